@@ -8,45 +8,107 @@
 
 #include "src/audio/midi.h"
 #include "src/game.h"
+#include "src/game/handlers/flying.h"
+#include "src/game/handlers/jukebox.h"
+#include "src/game/handlers/logos.h"
 #include "src/game/loop/loop.h"
 #include "src/game/loop/state.h"
 #include "src/game/state.h"
+#include "src/gfx/batch.h"
 #include "src/gfx/deps/manager.h"
+#include "src/gfx/deps/pack.h"
 #include "src/gfx/deps/register.h"
 #include "src/gfx/modes.h"
+#include "src/gfx/palettes.h"
+#include "src/gfx/textcache.h"
+#include "src/utils/args.h"
+#include "src/utils/bench.h"
+
+// Dependencies of the first states of the game and the jukebox, which are
+// loaded in one go at startup. See dep_warm() for more information.
+DEP_MANIFEST *GAME_WARM_DEPS[] = { &LOGOS_DEPS, &FLYING_DEPS };
+DEP_MANIFEST *JUKEBOX_WARM_DEPS[] = { &JUKEBOX_DEPS };
 
 /**
  * Starts the game after the main program is executed.
  *
  * This initializes Allegro, then hands over control to the game loop.
+ * Returns 1 if the game's resources can't be loaded.
  */
-void start_game() {
-    initialize_resources();
+int start_game() {
+    if (initialize_resources() != 0) {
+        return 1;
+    }
+    dep_warm(GAME_WARM_DEPS, sizeof(GAME_WARM_DEPS) / sizeof(DEP_MANIFEST *));
     game_state.loop_state_post_init = STATE_LOGOS;
     game_loop();
+    return 0;
 }
 
 /**
  * Starts the application with the jukebox as the first state.
+ * Returns 1 if the game's resources can't be loaded.
  */
-void start_jukebox() {
-    initialize_resources();
+int start_jukebox() {
+    if (initialize_resources() != 0) {
+        return 1;
+    }
+    dep_warm(JUKEBOX_WARM_DEPS, 1);
     game_state.loop_state_post_init = STATE_JUKEBOX;
     game_loop();
+    return 0;
+}
+
+/**
+ * Runs the benchmarks instead of the game. The results are written
+ * to 'bench.txt'. Returns 1 if the file can't be written.
+ */
+int start_bench() {
+    char fn[] = "bench.txt";
+    FILE *out;
+
+    initialize_allegro();
+    if (register_resources() != 0) {
+        printf("\r\nError: couldn't read %s.", PACK_PATH);
+        return 1;
+    }
+    if (arg_pool_kb != ARG_POOL_DEFAULT) {
+        dep_set_pool_budget(arg_pool_kb * 1024);
+    }
+
+    out = fopen(fn, "w");
+    if (out == NULL) {
+        printf("\r\nError: couldn't open %s for writing.", fn);
+        return 1;
+    }
+    run_benchmarks(out);
+    fclose(out);
+    printf("\r\nWrote benchmark results to %s.", fn);
+    return 0;
 }
 
 /**
  * Performs all initialization that must occur regardless of which
  * initial state we're using.
+ * Returns 1 if the resource pack is missing or can't be read.
  */
-void initialize_resources() {
+int initialize_resources() {
     // Install Allegro drivers.
     initialize_allegro();
     initialize_sound();
+    // Start the timer used for palette fades.
+    pal_init();
     // Register our game resources to the dependency manager.
-    register_resources();
+    if (register_resources() != 0) {
+        printf("\r\nError: couldn't read %s.", PACK_PATH);
+        return 1;
+    }
+    if (arg_pool_kb != ARG_POOL_DEFAULT) {
+        dep_set_pool_budget(arg_pool_kb * 1024);
+    }
     // Set up the game state defaults.
     initialize_game_state();
+    return 0;
 }
 
 /**
@@ -59,8 +121,14 @@ void shutdown() {
     screen_text_mode();
     printf("Thanks for playing Ceegee.\r\n");
 
-    // Print out the resource list if debugging.
+    // Print out the resource list if debugging, and save it to a file.
+    // Any resources that still have owners at this point are leaks.
     if (DEBUG) {
         debug_res_list();
+        debug_text_cache(stdout);
+        debug_batch_stats(stdout);
+        write_res_report("resinfo.txt");
     }
+    // Free everything that was only kept around in case it was needed again.
+    dep_flush_pool();
 }
@@ -6,9 +6,10 @@
 #ifndef __CEEGEE_GAME__
 #define __CEEGEE_GAME__
 
-void start_game();
-void start_jukebox();
+int initialize_resources();
+int start_bench();
+int start_game();
+int start_jukebox();
 void shutdown();
-void initialize_resources();
 
 #endif
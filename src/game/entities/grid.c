@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "src/game/entities/grid.h"
+#include "src/game/entities/pool.h"
+
+/**
+ * Creates a grid for the entities in a pool. Everything the grid needs
+ * is allocated here, so building and querying it never allocates.
+ * Returns NULL if there isn't enough memory.
+ */
+COL_GRID *grid_create(ENT_POOL *pool) {
+    COL_GRID *grid = malloc(sizeof(COL_GRID));
+    int n = pool->capacity;
+    int a;
+
+    if (!grid) {
+        return NULL;
+    }
+    grid->pool = pool;
+    grid->mask = 0;
+    grid->item_max = n * GRID_CELLS_PER_ENT;
+    grid->items = malloc(grid->item_max * sizeof(int));
+    grid->box_x1 = malloc(n * sizeof(short));
+    grid->box_y1 = malloc(n * sizeof(short));
+    grid->box_x2 = malloc(n * sizeof(short));
+    grid->box_y2 = malloc(n * sizeof(short));
+    grid->stamp = malloc(n * sizeof(unsigned long));
+    if (!grid->items || !grid->box_x1 || !grid->box_y1 || !grid->box_x2 ||
+        !grid->box_y2 || !grid->stamp) {
+        grid_destroy(grid);
+        return NULL;
+    }
+    for (a = 0; a < n; ++a) {
+        grid->stamp[a] = 0;
+    }
+    for (a = 0; a <= GRID_CELLS; ++a) {
+        grid->cell_start[a] = 0;
+    }
+    grid->query = 0;
+    grid->dropped = 0;
+    grid->tests = 0;
+    return grid;
+}
+
+/**
+ * Frees a grid. The pool it was made for is left alone.
+ */
+void grid_destroy(COL_GRID *grid) {
+    if (!grid) {
+        return;
+    }
+    free(grid->items);
+    free(grid->box_x1);
+    free(grid->box_y1);
+    free(grid->box_x2);
+    free(grid->box_y2);
+    free(grid->stamp);
+    free(grid);
+}
+
+/**
+ * Sets the range of cells covered by a rectangle. The corners are
+ * inclusive. Rectangles outside of the grid use the cells along its edge.
+ */
+static void grid_cells(int x1, int y1, int x2, int y2, int *c1, int *r1,
+    int *c2, int *r2)
+{
+    *c1 = MID(0, x1 >> GRID_CELL_BITS, GRID_COLS - 1);
+    *r1 = MID(0, y1 >> GRID_CELL_BITS, GRID_ROWS - 1);
+    *c2 = MID(0, x2 >> GRID_CELL_BITS, GRID_COLS - 1);
+    *r2 = MID(0, y2 >> GRID_CELL_BITS, GRID_ROWS - 1);
+}
+
+/**
+ * Copies an entity's bounding box into the grid. Entities without
+ * a sprite are treated as a single pixel.
+ */
+static void grid_box(COL_GRID *grid, int a) {
+    ENT_POOL *pool = grid->pool;
+    int x = fixtoi(pool->x[a]);
+    int y = fixtoi(pool->y[a]);
+
+    grid->box_x1[a] = x;
+    grid->box_y1[a] = y;
+    if (pool->frame[a]) {
+        grid->box_x2[a] = x + pool->frame[a]->w - 1;
+        grid->box_y2[a] = y + pool->frame[a]->h - 1;
+    }
+    else {
+        grid->box_x2[a] = x;
+        grid->box_y2[a] = y;
+    }
+}
+
+/**
+ * Rebuilds the grid from the current positions of the entities that have
+ * one of the flags in mask. Should be called once per tick, after moving
+ * the entities and before querying.
+ *
+ * This is a counting sort of entities by cell: first the number of entities
+ * in each cell is counted, which gives the start of every cell in the item
+ * list, and then the entities are put in place. Both passes are linear.
+ */
+void grid_build(COL_GRID *grid, int mask) {
+    ENT_POOL *pool = grid->pool;
+    int pos[GRID_CELLS];
+    int a, n, c, r, c1, r1, c2, r2;
+
+    grid->mask = mask;
+    grid->dropped = 0;
+    grid->tests = 0;
+    for (n = 0; n <= GRID_CELLS; ++n) {
+        grid->cell_start[n] = 0;
+    }
+
+    // Count the entities in each cell. The count for cell n is stored
+    // in cell_start[n + 1], so that the sums below give each start.
+    for (a = 0; a < pool->count; ++a) {
+        grid_box(grid, a);
+        if (!(pool->flags[a] & mask)) {
+            continue;
+        }
+        grid_cells(grid->box_x1[a], grid->box_y1[a], grid->box_x2[a],
+            grid->box_y2[a], &c1, &r1, &c2, &r2);
+        for (r = r1; r <= r2; ++r) {
+            for (c = c1; c <= c2; ++c) {
+                grid->cell_start[r * GRID_COLS + c + 1] += 1;
+            }
+        }
+    }
+    for (n = 0; n < GRID_CELLS; ++n) {
+        grid->cell_start[n + 1] += grid->cell_start[n];
+    }
+    for (n = 0; n <= GRID_CELLS; ++n) {
+        grid->cell_start[n] = MIN(grid->cell_start[n], grid->item_max);
+    }
+
+    for (n = 0; n < GRID_CELLS; ++n) {
+        pos[n] = grid->cell_start[n];
+    }
+    for (a = 0; a < pool->count; ++a) {
+        if (!(pool->flags[a] & mask)) {
+            continue;
+        }
+        grid_cells(grid->box_x1[a], grid->box_y1[a], grid->box_x2[a],
+            grid->box_y2[a], &c1, &r1, &c2, &r2);
+        for (r = r1; r <= r2; ++r) {
+            for (c = c1; c <= c2; ++c) {
+                n = r * GRID_COLS + c;
+                if (pos[n] < grid->cell_start[n + 1]) {
+                    grid->items[pos[n]++] = a;
+                }
+                else {
+                    grid->dropped += 1;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Finds the entities in the grid whose bounding boxes overlap a rectangle.
+ * The corners are inclusive. The entity at index skip is ignored, which is
+ * useful when querying with an entity's own box; pass -1 to include all.
+ * Up to max indices are written to found. Returns the number found.
+ */
+int grid_query(COL_GRID *grid, int x1, int y1, int x2, int y2, int skip,
+    int *found, int max)
+{
+    int c, r, c1, r1, c2, r2;
+    int a, b, end, n = 0;
+
+    grid->query += 1;
+    grid_cells(x1, y1, x2, y2, &c1, &r1, &c2, &r2);
+    for (r = r1; r <= r2; ++r) {
+        for (c = c1; c <= c2; ++c) {
+            a = grid->cell_start[r * GRID_COLS + c];
+            end = grid->cell_start[r * GRID_COLS + c + 1];
+            for (; a < end; ++a) {
+                b = grid->items[a];
+                if (b == skip || grid->stamp[b] == grid->query) {
+                    continue;
+                }
+                grid->stamp[b] = grid->query;
+                grid->tests += 1;
+                if (grid->box_x1[b] > x2 || grid->box_x2[b] < x1 ||
+                    grid->box_y1[b] > y2 || grid->box_y2[b] < y1) {
+                    continue;
+                }
+                if (n == max) {
+                    return n;
+                }
+                found[n++] = b;
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * Finds all pairs of overlapping entities, where the first entity has one
+ * of the flags in mask and the second is in the grid. Pairs of entities
+ * that are both in the grid are reported only once.
+ * Up to max pairs are written. Returns the number found.
+ */
+int grid_pairs(COL_GRID *grid, int mask, GRID_PAIR *pairs, int max) {
+    ENT_POOL *pool = grid->pool;
+    int found[GRID_QUERY_MAX];
+    int a, b, m, n = 0;
+
+    for (a = 0; a < pool->count && n < max; ++a) {
+        if (!(pool->flags[a] & mask)) {
+            continue;
+        }
+        m = grid_query(
+            grid, grid->box_x1[a], grid->box_y1[a], grid->box_x2[a],
+            grid->box_y2[a], a, found, GRID_QUERY_MAX
+        );
+        for (b = 0; b < m && n < max; ++b) {
+            // If both entities query and are in the grid, the pair was
+            // already found when the one with the lower index queried.
+            if (found[b] < a && (pool->flags[found[b]] & mask) &&
+                (pool->flags[a] & grid->mask)) {
+                continue;
+            }
+            pairs[n].a = a;
+            pairs[n].b = found[b];
+            n += 1;
+        }
+    }
+    return n;
+}
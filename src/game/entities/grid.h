@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GAME_ENTITIES_GRID__
+#define __CEEGEE_GAME_ENTITIES_GRID__
+
+#include "src/game/entities/pool.h"
+#include "src/gfx/modes.h"
+
+// Cells are 32x32 pixels. The grid covers the playfield; anything
+// outside of it is put in the nearest cell along the edge.
+#define GRID_CELL_BITS 5
+#define GRID_CELL_SIZE (1 << GRID_CELL_BITS)
+#define GRID_COLS ((CEEGEE_SCR_W + GRID_CELL_SIZE - 1) >> GRID_CELL_BITS)
+#define GRID_ROWS ((CEEGEE_SCR_H + GRID_CELL_SIZE - 1) >> GRID_CELL_BITS)
+#define GRID_CELLS (GRID_COLS * GRID_ROWS)
+// Average number of cells an entity is expected to overlap. Entities
+// that don't fit in the grid's cell list anymore are left out of it.
+#define GRID_CELLS_PER_ENT 4
+// Maximum number of overlapping entities grid_pairs() finds per entity.
+#define GRID_QUERY_MAX 64
+
+// A pair of entities whose bounding boxes overlap, as indices in the
+// pool's component arrays. a is the querying entity, b the one in the grid.
+typedef struct GRID_PAIR {
+    int a, b;
+} GRID_PAIR;
+
+// Uniform grid of the entities of a pool matching a set of flags.
+// cell_start[n] is the position in items of the first entity in cell n;
+// cell n ends where cell n + 1 starts. The entities' bounding boxes are
+// copied into box_x1 to box_y2 (indexed by pool index) when the grid
+// is built, so queries don't need to look at the sprites.
+// stamp is used to report every entity only once per query.
+typedef struct COL_GRID {
+    ENT_POOL *pool;
+    int mask;
+    int cell_start[GRID_CELLS + 1];
+    int *items;
+    int item_max;
+    short *box_x1, *box_y1, *box_x2, *box_y2;
+    unsigned long *stamp;
+    unsigned long query;
+    int dropped;
+    long tests;
+} COL_GRID;
+
+COL_GRID *grid_create(ENT_POOL *pool);
+int grid_pairs(COL_GRID *grid, int mask, GRID_PAIR *pairs, int max);
+int grid_query(COL_GRID *grid, int x1, int y1, int x2, int y2, int skip,
+    int *found, int max);
+static void grid_cells(int x1, int y1, int x2, int y2, int *c1, int *r1,
+    int *c2, int *r2);
+static void grid_box(COL_GRID *grid, int a);
+void grid_build(COL_GRID *grid, int mask);
+void grid_destroy(COL_GRID *grid);
+
+#endif
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "src/game/entities/particles.h"
+#include "src/gfx/modes.h"
+
+/**
+ * Creates a particle system that can hold up to a number of particles of
+ * 1x1 or 2x2 pixels. Everything is allocated here; emitting, updating and
+ * drawing particles never allocates. Particles are removed when they leave
+ * the screen, and are drawn with color 0 until a ramp is set.
+ * Returns NULL if there isn't enough memory.
+ */
+PART_SYSTEM *part_create(int capacity, int size) {
+    PART_SYSTEM *sys = malloc(sizeof(PART_SYSTEM));
+
+    if (!sys) {
+        return NULL;
+    }
+    sys->capacity = MAX(1, capacity);
+    sys->count = 0;
+    sys->size = MID(1, size, 2);
+    sys->gravity = 0;
+    sys->x = malloc(sys->capacity * sizeof(fixed));
+    sys->y = malloc(sys->capacity * sizeof(fixed));
+    sys->vx = malloc(sys->capacity * sizeof(fixed));
+    sys->vy = malloc(sys->capacity * sizeof(fixed));
+    sys->life = malloc(sys->capacity * sizeof(unsigned char));
+    if (!sys->x || !sys->y || !sys->vx || !sys->vy || !sys->life) {
+        part_destroy(sys);
+        return NULL;
+    }
+    part_set_bounds(sys, 0, 0, CEEGEE_SCR_W - 1, CEEGEE_SCR_H - 1);
+    part_set_ramp(sys, 0, 1, 0);
+    return sys;
+}
+
+/**
+ * Frees a particle system.
+ */
+void part_destroy(PART_SYSTEM *sys) {
+    if (!sys) {
+        return;
+    }
+    free(sys->x);
+    free(sys->y);
+    free(sys->vx);
+    free(sys->vy);
+    free(sys->life);
+    free(sys);
+}
+
+/**
+ * Removes all particles.
+ */
+void part_clear(PART_SYSTEM *sys) {
+    sys->count = 0;
+}
+
+/**
+ * Sets the area particles can be in. Particles that leave it are removed.
+ * The corners are inclusive.
+ */
+void part_set_bounds(PART_SYSTEM *sys, int x1, int y1, int x2, int y2) {
+    sys->x1 = itofix(x1);
+    sys->y1 = itofix(y1);
+    sys->x2 = itofix(x2);
+    sys->y2 = itofix(y2);
+}
+
+/**
+ * Sets the colors particles go through as they die. The ramp is a range
+ * of n palette entries starting at first: a particle is drawn with the
+ * last one while it has ticks or more ticks to live, and then fades
+ * towards the first one. The color of every possible remaining life is
+ * looked up here, so drawing a particle only needs a single table lookup.
+ */
+void part_set_ramp(PART_SYSTEM *sys, int first, int n, int ticks) {
+    int a, step;
+
+    n = MAX(1, n);
+    for (a = 0; a <= PART_LIFE_MAX; ++a) {
+        step = ticks > 0 ? (a * n) / ticks : n - 1;
+        sys->color[a] = first + MIN(step, n - 1);
+    }
+}
+
+/**
+ * Fills a range of palette entries with a gradient, for use as a particle
+ * color ramp. Entry first is set to from, and entry first + n - 1 to to.
+ */
+void part_ramp_colors(RGB *pal, int first, int n, RGB *from, RGB *to) {
+    int a, d = MAX(1, n - 1);
+
+    for (a = 0; a < n; ++a) {
+        pal[first + a].r = from->r + ((to->r - from->r) * a) / d;
+        pal[first + a].g = from->g + ((to->g - from->g) * a) / d;
+        pal[first + a].b = from->b + ((to->b - from->b) * a) / d;
+    }
+}
+
+/**
+ * Adds a particle that lives for a number of ticks.
+ * Returns false if the system is full.
+ */
+bool part_emit(PART_SYSTEM *sys, fixed x, fixed y, fixed vx, fixed vy,
+    int life)
+{
+    int a = sys->count;
+
+    if (a == sys->capacity) {
+        return false;
+    }
+    sys->x[a] = x;
+    sys->y[a] = y;
+    sys->vx[a] = vx;
+    sys->vy[a] = vy;
+    sys->life[a] = MID(1, life, PART_LIFE_MAX);
+    sys->count += 1;
+    return true;
+}
+
+/**
+ * Moves every particle by its velocity and ages it by one tick. Particles
+ * that die or leave the bounds are replaced by the last particle, which
+ * hasn't been updated yet, so it's updated next in the same spot.
+ */
+void part_update(PART_SYSTEM *sys) {
+    fixed *x = sys->x, *y = sys->y;
+    fixed *vx = sys->vx, *vy = sys->vy;
+    unsigned char *life = sys->life;
+    fixed gravity = sys->gravity;
+    fixed x1 = sys->x1, y1 = sys->y1, x2 = sys->x2, y2 = sys->y2;
+    int a = 0, n = sys->count;
+
+    while (a < n) {
+        x[a] += vx[a];
+        y[a] += vy[a];
+        vy[a] += gravity;
+        life[a] -= 1;
+        if (life[a] == 0 || x[a] < x1 || x[a] > x2 || y[a] < y1 ||
+            y[a] > y2) {
+            n -= 1;
+            x[a] = x[n];
+            y[a] = y[n];
+            vx[a] = vx[n];
+            vy[a] = vy[n];
+            life[a] = life[n];
+            continue;
+        }
+        a += 1;
+    }
+    sys->count = n;
+}
+
+/**
+ * Draws the particles into an 8-bit memory bitmap by writing straight
+ * into its lines. Particles that aren't entirely inside the clip
+ * rectangle aren't drawn.
+ */
+static void part_draw_direct(PART_SYSTEM *sys, BITMAP *buffer, int cl,
+    int ct, int cr, int cb)
+{
+    fixed *x = sys->x, *y = sys->y;
+    unsigned char *life = sys->life;
+    unsigned char *color = sys->color;
+    unsigned char *row;
+    int a, px, py, c, n = sys->count;
+
+    if (sys->size == 1) {
+        for (a = 0; a < n; ++a) {
+            px = fixtoi(x[a]);
+            py = fixtoi(y[a]);
+            if (px < cl || py < ct || px >= cr || py >= cb) {
+                continue;
+            }
+            buffer->line[py][px] = color[life[a]];
+        }
+        return;
+    }
+    for (a = 0; a < n; ++a) {
+        px = fixtoi(x[a]);
+        py = fixtoi(y[a]);
+        if (px < cl || py < ct || px + 1 >= cr || py + 1 >= cb) {
+            continue;
+        }
+        c = color[life[a]];
+        row = buffer->line[py] + px;
+        row[0] = row[1] = c;
+        row = buffer->line[py + 1] + px;
+        row[0] = row[1] = c;
+    }
+}
+
+/**
+ * Draws the particles onto a buffer. If the buffer is an 8-bit memory
+ * bitmap, the pixels are written directly; otherwise they're drawn
+ * with _putpixel(). The flying handler draws into a memory bitmap
+ * of its own, so it takes the first path.
+ */
+void part_draw(PART_SYSTEM *sys, BITMAP *buffer) {
+    int cl = 0, ct = 0, cr = buffer->w, cb = buffer->h;
+    int a, px, py, c, s = sys->size;
+
+    if (buffer->clip) {
+        cl = buffer->cl;
+        ct = buffer->ct;
+        cr = buffer->cr;
+        cb = buffer->cb;
+    }
+    if (is_memory_bitmap(buffer) && bitmap_color_depth(buffer) == 8) {
+        part_draw_direct(sys, buffer, cl, ct, cr, cb);
+        return;
+    }
+
+    acquire_bitmap(buffer);
+    for (a = 0; a < sys->count; ++a) {
+        px = fixtoi(sys->x[a]);
+        py = fixtoi(sys->y[a]);
+        if (px < cl || py < ct || px + s > cr || py + s > cb) {
+            continue;
+        }
+        c = palette_color[sys->color[sys->life[a]]];
+        _putpixel(buffer, px, py, c);
+        if (s == 2) {
+            _putpixel(buffer, px + 1, py, c);
+            _putpixel(buffer, px, py + 1, c);
+            _putpixel(buffer, px + 1, py + 1, c);
+        }
+    }
+    release_bitmap(buffer);
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GAME_ENTITIES_PARTICLES__
+#define __CEEGEE_GAME_ENTITIES_PARTICLES__
+
+// Particles live for at most this many ticks.
+#define PART_LIFE_MAX 255
+
+// Particle system, stored as one array per field. The live particles always
+// occupy indices 0 to count - 1; when one dies, the last one is moved into
+// its place. Positions and velocities are fixed point numbers.
+// Particles are removed once they leave the area from x1, y1 to x2, y2.
+// color maps a particle's remaining life to a palette index.
+// size is the width and height of each particle in pixels (1 or 2).
+typedef struct PART_SYSTEM {
+    int capacity;
+    int count;
+    fixed *x, *y;
+    fixed *vx, *vy;
+    unsigned char *life;
+    unsigned char color[PART_LIFE_MAX + 1];
+    fixed gravity;
+    fixed x1, y1, x2, y2;
+    int size;
+} PART_SYSTEM;
+
+PART_SYSTEM *part_create(int capacity, int size);
+bool part_emit(PART_SYSTEM *sys, fixed x, fixed y, fixed vx, fixed vy,
+    int life);
+static void part_draw_direct(PART_SYSTEM *sys, BITMAP *buffer, int cl,
+    int ct, int cr, int cb);
+void part_clear(PART_SYSTEM *sys);
+void part_destroy(PART_SYSTEM *sys);
+void part_draw(PART_SYSTEM *sys, BITMAP *buffer);
+void part_ramp_colors(RGB *pal, int first, int n, RGB *from, RGB *to);
+void part_set_bounds(PART_SYSTEM *sys, int x1, int y1, int x2, int y2);
+void part_set_ramp(PART_SYSTEM *sys, int first, int n, int ticks);
+void part_update(PART_SYSTEM *sys);
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "src/game/entities/pool.h"
+#include "src/gfx/batch.h"
+#include "src/gfx/frames.h"
+#include "src/gfx/masks.h"
+
+// Collision mask of entities without a sprite: a single solid pixel.
+unsigned long ent_point_bits[1] = { 1UL << (MASK_WORD_BITS - 1) };
+COL_MASK ent_point = { 1, 1, 1, ent_point_bits };
+
+/**
+ * Creates a pool that can hold up to a number of entities. Everything
+ * the pool needs is allocated here; spawning and removing entities
+ * never allocates. Returns NULL if there isn't enough memory.
+ */
+ENT_POOL *ent_pool_create(int capacity) {
+    ENT_POOL *pool;
+    int a;
+
+    capacity = MID(1, capacity, ENT_CAPACITY_MAX);
+    pool = malloc(sizeof(ENT_POOL));
+    if (!pool) {
+        return NULL;
+    }
+    pool->capacity = capacity;
+    pool->count = 0;
+    pool->x = malloc(capacity * sizeof(fixed));
+    pool->y = malloc(capacity * sizeof(fixed));
+    pool->vx = malloc(capacity * sizeof(fixed));
+    pool->vy = malloc(capacity * sizeof(fixed));
+    pool->frame = malloc(capacity * sizeof(SPR_FRAME *));
+    pool->flags = malloc(capacity * sizeof(unsigned char));
+    pool->index_slot = malloc(capacity * sizeof(int));
+    pool->slot_index = malloc(capacity * sizeof(int));
+    pool->slot_gen = malloc(capacity * sizeof(int));
+    pool->slot_next = malloc(capacity * sizeof(int));
+    if (!pool->x || !pool->y || !pool->vx || !pool->vy || !pool->frame ||
+        !pool->flags || !pool->index_slot || !pool->slot_index ||
+        !pool->slot_gen || !pool->slot_next) {
+        ent_pool_destroy(pool);
+        return NULL;
+    }
+    for (a = 0; a < capacity; ++a) {
+        pool->slot_gen[a] = 1;
+    }
+    ent_pool_clear(pool);
+    return pool;
+}
+
+/**
+ * Frees a pool and all of its component arrays.
+ */
+void ent_pool_destroy(ENT_POOL *pool) {
+    if (!pool) {
+        return;
+    }
+    free(pool->x);
+    free(pool->y);
+    free(pool->vx);
+    free(pool->vy);
+    free(pool->frame);
+    free(pool->flags);
+    free(pool->index_slot);
+    free(pool->slot_index);
+    free(pool->slot_gen);
+    free(pool->slot_next);
+    free(pool);
+}
+
+/**
+ * Removes all entities from a pool. IDs of removed entities
+ * stay invalid, since every slot's generation is incremented.
+ */
+void ent_pool_clear(ENT_POOL *pool) {
+    int a;
+
+    while (pool->count > 0) {
+        ent_kill_index(pool, pool->count - 1);
+    }
+    for (a = 0; a < pool->capacity; ++a) {
+        pool->slot_index[a] = -1;
+        pool->slot_next[a] = a + 1 < pool->capacity ? a + 1 : -1;
+    }
+    pool->free_slot = 0;
+}
+
+/**
+ * Adds an entity to a pool. Returns its ID, or ENT_NONE if the pool
+ * is full.
+ */
+int ent_spawn(ENT_POOL *pool, fixed x, fixed y, fixed vx, fixed vy,
+    SPR_FRAME *frame, int flags)
+{
+    int slot = pool->free_slot;
+    int index = pool->count;
+
+    if (slot == -1) {
+        return ENT_NONE;
+    }
+    pool->free_slot = pool->slot_next[slot];
+    pool->slot_index[slot] = index;
+    pool->index_slot[index] = slot;
+    pool->x[index] = x;
+    pool->y[index] = y;
+    pool->vx[index] = vx;
+    pool->vy[index] = vy;
+    pool->frame[index] = frame;
+    pool->flags[index] = flags;
+    pool->count += 1;
+    return (pool->slot_gen[slot] << ENT_SLOT_BITS) | slot;
+}
+
+/**
+ * Returns the current index of an entity in the component arrays,
+ * or -1 if the ID is stale (the entity was removed).
+ */
+int ent_index(ENT_POOL *pool, int id) {
+    int slot = id & ENT_SLOT_MASK;
+    int gen = id >> ENT_SLOT_BITS;
+
+    if (id <= 0 || slot >= pool->capacity || pool->slot_gen[slot] != gen) {
+        return -1;
+    }
+    return pool->slot_index[slot];
+}
+
+/**
+ * Returns the ID of the entity at an index in the component arrays.
+ */
+int ent_id(ENT_POOL *pool, int index) {
+    int slot = pool->index_slot[index];
+    return (pool->slot_gen[slot] << ENT_SLOT_BITS) | slot;
+}
+
+/**
+ * Returns whether an entity still exists.
+ */
+bool ent_alive(ENT_POOL *pool, int id) {
+    return ent_index(pool, id) != -1;
+}
+
+/**
+ * Removes the entity at an index. The last entity is moved into its
+ * place, so when removing entities while iterating over the pool,
+ * iterate from the end to the start.
+ */
+void ent_kill_index(ENT_POOL *pool, int index) {
+    int slot = pool->index_slot[index];
+    int last = pool->count - 1;
+    int moved;
+
+    if (index != last) {
+        moved = pool->index_slot[last];
+        pool->x[index] = pool->x[last];
+        pool->y[index] = pool->y[last];
+        pool->vx[index] = pool->vx[last];
+        pool->vy[index] = pool->vy[last];
+        pool->frame[index] = pool->frame[last];
+        pool->flags[index] = pool->flags[last];
+        pool->index_slot[index] = moved;
+        pool->slot_index[moved] = index;
+    }
+    pool->count -= 1;
+    pool->slot_index[slot] = -1;
+    pool->slot_gen[slot] = (pool->slot_gen[slot] % ENT_GEN_MAX) + 1;
+    pool->slot_next[slot] = pool->free_slot;
+    pool->free_slot = slot;
+}
+
+/**
+ * Removes an entity by its ID. Stale IDs are ignored.
+ */
+void ent_kill(ENT_POOL *pool, int id) {
+    int index = ent_index(pool, id);
+
+    if (index != -1) {
+        ent_kill_index(pool, index);
+    }
+}
+
+/**
+ * Moves every entity by its velocity.
+ */
+void ent_update(ENT_POOL *pool) {
+    fixed *x = pool->x, *y = pool->y;
+    fixed *vx = pool->vx, *vy = pool->vy;
+    int a, n = pool->count;
+
+    for (a = 0; a < n; ++a) {
+        x[a] += vx[a];
+        y[a] += vy[a];
+    }
+}
+
+/**
+ * Returns whether the sprites of two entities overlap, pixel for pixel.
+ * This is the narrow phase: it should only be used for pairs whose
+ * bounding boxes are known to overlap, e.g. the ones found by the grid.
+ * Entities without a sprite are a single solid pixel.
+ */
+bool ent_collide(ENT_POOL *pool, int a, int b) {
+    COL_MASK *ma = pool->frame[a] ? pool->frame[a]->mask : &ent_point;
+    COL_MASK *mb = pool->frame[b] ? pool->frame[b]->mask : &ent_point;
+
+    return mask_collide(
+        ma, fixtoi(pool->x[a]), fixtoi(pool->y[a]),
+        mb, fixtoi(pool->x[b]), fixtoi(pool->y[b])
+    );
+}
+
+/**
+ * Removes every entity whose position is outside of a rectangle,
+ * e.g. bullets that have left the playfield.
+ */
+void ent_remove_outside(ENT_POOL *pool, int x1, int y1, int x2, int y2) {
+    fixed fx1 = itofix(x1), fy1 = itofix(y1);
+    fixed fx2 = itofix(x2), fy2 = itofix(y2);
+    int a;
+
+    for (a = pool->count - 1; a >= 0; --a) {
+        if (pool->x[a] < fx1 || pool->x[a] > fx2 ||
+            pool->y[a] < fy1 || pool->y[a] > fy2) {
+            ent_kill_index(pool, a);
+        }
+    }
+}
+
+/**
+ * Submits every visible entity to the sprite batch.
+ */
+void ent_draw(ENT_POOL *pool, int layer) {
+    int a;
+
+    for (a = 0; a < pool->count; ++a) {
+        if (!pool->frame[a] || (pool->flags[a] & ENT_HIDDEN)) {
+            continue;
+        }
+        batch_add(
+            pool->frame[a], fixtoi(pool->x[a]), fixtoi(pool->y[a]), layer
+        );
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GAME_ENTITIES_POOL__
+#define __CEEGEE_GAME_ENTITIES_POOL__
+
+#include "src/gfx/frames.h"
+
+// Entity IDs contain a slot number in the lower bits, and the slot's
+// generation in the upper bits, like resource handles.
+#define ENT_SLOT_BITS 16
+#define ENT_SLOT_MASK ((1 << ENT_SLOT_BITS) - 1)
+#define ENT_GEN_MAX 0x7FFF
+// Largest number of entities a pool can hold.
+#define ENT_CAPACITY_MAX ENT_SLOT_MASK
+// Never a valid entity ID.
+#define ENT_NONE 0
+
+// Entity flags.
+#define ENT_PLAYER 0x01
+#define ENT_ENEMY 0x02
+#define ENT_BULLET 0x04
+#define ENT_HIDDEN 0x08
+
+// Pool of entities, stored as one array per component. The live entities
+// always occupy indices 0 to count - 1 of the component arrays, so they
+// can be iterated over without gaps. When an entity is removed, the last
+// one is moved into its place, so an entity's index can change; its ID
+// doesn't. Positions and velocities are fixed point numbers.
+//
+// The component arrays are indexed by dense index. The slot arrays are
+// indexed by the slot number in an entity's ID: slot_index is the entity's
+// current dense index, and slot_gen its generation. index_slot maps
+// dense indices back to slots. Free slots form a list using slot_next.
+typedef struct ENT_POOL {
+    int capacity;
+    int count;
+    fixed *x, *y;
+    fixed *vx, *vy;
+    SPR_FRAME **frame;
+    unsigned char *flags;
+    int *index_slot;
+    int *slot_index;
+    int *slot_gen;
+    int *slot_next;
+    int free_slot;
+} ENT_POOL;
+
+ENT_POOL *ent_pool_create(int capacity);
+bool ent_alive(ENT_POOL *pool, int id);
+bool ent_collide(ENT_POOL *pool, int a, int b);
+int ent_id(ENT_POOL *pool, int index);
+int ent_index(ENT_POOL *pool, int id);
+int ent_spawn(ENT_POOL *pool, fixed x, fixed y, fixed vx, fixed vy,
+    SPR_FRAME *frame, int flags);
+void ent_draw(ENT_POOL *pool, int layer);
+void ent_kill(ENT_POOL *pool, int id);
+void ent_kill_index(ENT_POOL *pool, int index);
+void ent_pool_clear(ENT_POOL *pool);
+void ent_pool_destroy(ENT_POOL *pool);
+void ent_remove_outside(ENT_POOL *pool, int x1, int y1, int x2, int y2);
+void ent_update(ENT_POOL *pool);
+
+#endif
@@ -6,40 +6,254 @@
 #include <allegro.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <xorshift.h>
 
+#include "src/game/entities/grid.h"
+#include "src/game/entities/particles.h"
+#include "src/game/entities/pool.h"
 #include "src/game/handlers/flying.h"
 #include "src/game/sprites/ships.h"
 #include "src/game/loop/state.h"
+#include "src/gfx/batch.h"
 #include "src/gfx/deps/manager.h"
+#include "src/gfx/modes.h"
 #include "src/gfx/res/flim.h"
 #include "src/gfx/res/usp_talon.h"
 #include "src/gfx/text.h"
+#include "src/gfx/tilemap.h"
+#include "src/gfx/widgets.h"
 #include "src/utils/counters.h"
 
 SHIP theship;
 
+// Enemies and projectiles.
+ENT_POOL *flying_ents;
+// Grid of the enemies, rebuilt every tick, used to find bullets that hit.
+COL_GRID *flying_grid;
+GRID_PAIR flying_hits[FLYING_HITS_MAX];
+// Engine exhaust and other small effects.
+PART_SYSTEM *flying_parts;
+
+// Colors of the exhaust, from when a particle dies to when it's emitted.
+RGB EXHAUST_COLOR_FROM = { 16, 0, 0 };
+RGB EXHAUST_COLOR_TO = { 63, 56, 32 };
+
+// Scrolling background, its tiles and the current scroll position.
+// The view moves up the map, so the background moves down.
+TILEMAP *flying_map;
+BITMAP *flying_tileset;
+int flying_scroll;
+
+// Colors of the background, from darkest to lightest.
+RGB BG_COLOR_FROM = { 2, 3, 8 };
+RGB BG_COLOR_TO = { 24, 28, 40 };
+
+// The frame is drawn here and then copied to the screen in one blit.
+// Everything is drawn into an 8-bit memory bitmap, so the particles, text
+// and tiles can write to its lines directly rather than going through the
+// screen's drawing functions pixel by pixel.
+BITMAP *flying_buffer;
+
+// Debugging information about the ship.
+TXT_WIDGET debug_widget;
+
 DATAFILE* usp_talon_data;
 int REQ_ID_FLYING_HANDLER;
+// Whether the handler has everything it needs. If not, it exits right
+// away without drawing anything.
+bool flying_ok = false;
+
+// Dependencies of the flying handler.
+int *FLYING_DEPS_RES[] = { &RES_ID_FLIM, &RES_ID_USP_TALON, NULL };
+DEP_MANIFEST FLYING_DEPS = { FLYING_DEPS_RES, NULL };
 
 /**
  * Request the flying handler dependencies.
  */
 void flying_deps() {
     REQ_ID_FLYING_HANDLER = req_id();
-    dep_require(RES_ID_FLIM, REQ_ID_FLYING_HANDLER);
-    dep_require(RES_ID_USP_TALON, REQ_ID_FLYING_HANDLER);
+    dep_require_manifest(&FLYING_DEPS, REQ_ID_FLYING_HANDLER);
+}
+
+/**
+ * Formats the debugging information shown at the top of the screen.
+ */
+static void format_debug_info(char txt[TXT_MAX_SIZE]) {
+    uszprintf(txt, TXT_MAX_SIZE,
+        "x: %03d, y: %03d, w: %03d, h: %03d, pivot: %03d",
+        theship.x, theship.y, theship.w, theship.h, theship.pivot);
+}
+
+/**
+ * Draws the background tiles. Tiles 0 to 3 are empty space with a few
+ * stars; the rest are hull plates, with a seam, a grille and a light.
+ */
+static BITMAP *flying_make_tiles() {
+    BITMAP *tiles = create_bitmap_ex(8, FLYING_TILES_N * TILE_SIZE, TILE_SIZE);
+    int a, b, x, e = TILE_SIZE - 1;
+
+    if (!tiles) {
+        return NULL;
+    }
+    clear_to_color(tiles, BG_COLOR_FIRST);
+    for (a = 0; a < 4; ++a) {
+        for (b = 0; b < a; ++b) {
+            putpixel(
+                tiles, a * TILE_SIZE + xor32() % TILE_SIZE,
+                xor32() % TILE_SIZE, BG_COLOR_FIRST + 4 + xor32() % 4
+            );
+        }
+    }
+    for (a = 4; a < FLYING_TILES_N; ++a) {
+        x = a * TILE_SIZE;
+        rectfill(tiles, x, 0, x + e, e, BG_COLOR_FIRST + 2);
+        hline(tiles, x, 0, x + e, BG_COLOR_FIRST + 4);
+        vline(tiles, x, 0, e, BG_COLOR_FIRST + 4);
+        hline(tiles, x, e, x + e, BG_COLOR_FIRST + 1);
+        vline(tiles, x + e, 0, e, BG_COLOR_FIRST + 1);
+        putpixel(tiles, x + 2, 2, BG_COLOR_FIRST + 6);
+        putpixel(tiles, x + e - 2, 2, BG_COLOR_FIRST + 6);
+        putpixel(tiles, x + 2, e - 2, BG_COLOR_FIRST + 6);
+        putpixel(tiles, x + e - 2, e - 2, BG_COLOR_FIRST + 6);
+    }
+    vline(tiles, 5 * TILE_SIZE + 7, 1, e - 1, BG_COLOR_FIRST + 1);
+    vline(tiles, 5 * TILE_SIZE + 8, 1, e - 1, BG_COLOR_FIRST + 3);
+    for (b = 4; b < e - 2; b += 3) {
+        hline(tiles, 6 * TILE_SIZE + 4, b, 7 * TILE_SIZE - 5, BG_COLOR_FIRST);
+    }
+    circlefill(tiles, 7 * TILE_SIZE + 8, 8, 3, BG_COLOR_FIRST + 5);
+    circlefill(tiles, 7 * TILE_SIZE + 8, 8, 1, BG_COLOR_FIRST + 7);
+    return tiles;
+}
+
+/**
+ * Fills the background map: open space, with the hull of a station along
+ * both edges. The width of the hull wanders from row to row, and returns
+ * to where it started at the end, so that the map repeats seamlessly.
+ */
+static void flying_make_map() {
+    int c, r, left = 2, right = 2;
+
+    for (r = 0; r < FLYING_MAP_ROWS; ++r) {
+        if (r < FLYING_MAP_ROWS - 4) {
+            left = MID(0, left + (int)(xor32() % 3) - 1, 4);
+            right = MID(0, right + (int)(xor32() % 3) - 1, 4);
+        }
+        else {
+            left += left < 2 ? 1 : left > 2 ? -1 : 0;
+            right += right < 2 ? 1 : right > 2 ? -1 : 0;
+        }
+        for (c = 0; c < FLYING_MAP_COLS; ++c) {
+            if (c < left || c >= FLYING_MAP_COLS - right) {
+                tilemap_set(flying_map, c, r, 4 + xor32() % 4);
+            }
+            else {
+                tilemap_set(flying_map, c, r, xor32() % 4);
+            }
+        }
+    }
 }
 
 /**
  * Initialize the flying handler.
+ *
+ * If its resources or the entity pool, grid or particle system can't be
+ * made, the handler isn't started; flying_exit() frees whatever was made.
+ * The background and back buffer are optional.
  */
 void flying_init() {
+    flying_ok = false;
     usp_talon_data = dep_data_ref(RES_ID_USP_TALON);
+    if (!usp_talon_data) {
+        return;
+    }
     add_text_colors(usp_talon_data[USP_TALON_PALETTE].dat);
+    part_ramp_colors(
+        usp_talon_data[USP_TALON_PALETTE].dat, EXHAUST_COLOR_FIRST,
+        EXHAUST_COLOR_N, &EXHAUST_COLOR_FROM, &EXHAUST_COLOR_TO
+    );
+    part_ramp_colors(
+        usp_talon_data[USP_TALON_PALETTE].dat, BG_COLOR_FIRST,
+        BG_COLOR_N, &BG_COLOR_FROM, &BG_COLOR_TO
+    );
     set_palette(usp_talon_data[USP_TALON_PALETTE].dat);
 
-    theship = ship_create(USP_TALON, usp_talon_data);
+    theship = ship_create(USP_TALON);
     ship_set_pos(&theship, 150, 80);
+    flying_ents = ent_pool_create(FLYING_ENTS_MAX);
+    flying_grid = flying_ents ? grid_create(flying_ents) : NULL;
+    flying_parts = part_create(FLYING_PARTS_MAX, 1);
+    if (!flying_ents || !flying_grid || !flying_parts) {
+        return;
+    }
+    part_set_ramp(
+        flying_parts, EXHAUST_COLOR_FIRST, EXHAUST_COLOR_N, EXHAUST_LIFE
+    );
+    flying_buffer = create_bitmap_ex(8, CEEGEE_SCR_W, CEEGEE_SCR_H);
+    flying_tileset = flying_make_tiles();
+    flying_map = NULL;
+    flying_scroll = 0;
+    if (flying_tileset) {
+        flying_map = tilemap_create(
+            FLYING_MAP_COLS, FLYING_MAP_ROWS, flying_tileset, CEEGEE_SCR_W,
+            CEEGEE_SCR_H
+        );
+    }
+    if (flying_map) {
+        flying_make_map();
+    }
+
+    widget_init(&debug_widget, 0, 0, TXT_WHITE, -1, TXT_REGULAR, TXT_LEFT,
+        format_debug_info);
+    widget_bind(&debug_widget, &theship.x, sizeof(theship.x));
+    widget_bind(&debug_widget, &theship.y, sizeof(theship.y));
+    widget_bind(&debug_widget, &theship.pivot, sizeof(theship.pivot));
+    flying_ok = true;
+}
+
+/**
+ * Removes bullets that hit an enemy, along with the enemy. The grid finds
+ * the pairs whose bounding boxes overlap, which are then checked pixel
+ * for pixel. The pairs refer to indices, which change as entities are
+ * removed, so the hits are turned into IDs first; IDs of entities that
+ * were already removed are ignored.
+ */
+static void flying_collide() {
+    int a, n, hits = 0;
+
+    grid_build(flying_grid, ENT_ENEMY);
+    n = grid_pairs(flying_grid, ENT_BULLET, flying_hits, FLYING_HITS_MAX);
+    for (a = 0; a < n; ++a) {
+        if (!ent_collide(flying_ents, flying_hits[a].a, flying_hits[a].b)) {
+            continue;
+        }
+        flying_hits[hits].a = ent_id(flying_ents, flying_hits[a].a);
+        flying_hits[hits].b = ent_id(flying_ents, flying_hits[a].b);
+        hits += 1;
+    }
+    for (a = 0; a < hits; ++a) {
+        ent_kill(flying_ents, flying_hits[a].a);
+        ent_kill(flying_ents, flying_hits[a].b);
+    }
+}
+
+/**
+ * Emits the ship's engine exhaust from the bottom of its sprite.
+ * The particles spread out a little, and slowly drift downward.
+ */
+static void flying_exhaust() {
+    int a;
+
+    for (a = 0; a < EXHAUST_RATE; ++a) {
+        part_emit(
+            flying_parts,
+            itofix(theship.x + theship.w / 2 - 1 + (a & 1)),
+            itofix(theship.y + theship.h - 2),
+            (fixed)(xor32() % 0x8000) - 0x4000,
+            itofix(1) + (fixed)(xor32() % 0x10000),
+            EXHAUST_LIFE / 2 + xor32() % (EXHAUST_LIFE / 2)
+        );
+    }
 }
 
 /**
@@ -49,21 +263,64 @@ void flying_init() {
  * on the game state.
  */
 void flying_update() {
+    if (!flying_ok) {
+        return;
+    }
     poll_keyboard();
     ship_feed_input(&theship);
+
+    // Entities are removed once they're well outside of the playfield.
+    ent_update(flying_ents);
+    ent_remove_outside(
+        flying_ents,
+        -FLYING_ENTS_MARGIN,
+        -FLYING_ENTS_MARGIN,
+        CEEGEE_SCR_W + FLYING_ENTS_MARGIN,
+        CEEGEE_SCR_H + FLYING_ENTS_MARGIN
+    );
+    flying_collide();
+
+    part_update(flying_parts);
+    flying_exhaust();
+
+    flying_scroll -= FLYING_SCROLL_SPEED;
+    if (flying_map) {
+        tilemap_scroll_to(flying_map, 0, flying_scroll);
+    }
 }
 
 /**
  * Renders the output of the flying handler's current game state.
+ * The frame is drawn into the back buffer, and then copied to the screen.
+ * If there's no back buffer, it's drawn onto the screen itself.
  */
-void flying_render(BITMAP *buffer) {
-    clear_to_color(buffer, palette_color[252]);
-    ship_draw(&theship, buffer);
+void flying_render(BITMAP *screen_buffer) {
+    BITMAP *buffer = flying_buffer ? flying_buffer : screen_buffer;
+
+    if (!flying_ok) {
+        return;
+    }
+
+    // Only the tiles that scrolled into view are drawn each frame.
+    if (flying_map) {
+        tilemap_draw(flying_map, buffer, 0, 0);
+    }
+    else {
+        clear_to_color(buffer, palette_color[252]);
+    }
+    part_draw(flying_parts, buffer);
+
+    batch_begin(buffer);
+    ent_draw(flying_ents, LAYER_ENEMIES);
+    ship_draw(&theship);
+    batch_end();
 
     if (DEBUG) {
-        draw_textf(buffer, 0, 0, TXT_WHITE, -1, -1, TXT_REGULAR, TXT_LEFT,
-            "x: %03d, y: %03d, w: %03d, h: %03d, pivot: %03d",
-            theship.x, theship.y, theship.w, theship.h, theship.pivot);
+        widget_draw(&debug_widget, buffer);
+    }
+
+    if (buffer != screen_buffer) {
+        blit(buffer, screen_buffer, 0, 0, 0, 0, buffer->w, buffer->h);
     }
 }
 
@@ -71,7 +328,7 @@ void flying_render(BITMAP *buffer) {
  * Whether or not the flying handler will shutdown and exit.
  */
 bool flying_will_exit() {
-    if (key[KEY_ESC]) {
+    if (!flying_ok || key[KEY_ESC]) {
         return true;
     }
     return false;
@@ -81,8 +338,24 @@ bool flying_will_exit() {
  * Shutdown and exit the flying handler.
  */
 void flying_exit() {
-    dep_forget(RES_ID_FLIM, REQ_ID_FLYING_HANDLER);
-    dep_forget(RES_ID_USP_TALON, REQ_ID_FLYING_HANDLER);
+    widget_destroy(&debug_widget);
+    tilemap_destroy(flying_map);
+    if (flying_tileset) {
+        destroy_bitmap(flying_tileset);
+    }
+    flying_map = NULL;
+    flying_tileset = NULL;
+    if (flying_buffer) {
+        destroy_bitmap(flying_buffer);
+    }
+    flying_buffer = NULL;
+    part_destroy(flying_parts);
+    grid_destroy(flying_grid);
+    ent_pool_destroy(flying_ents);
+    flying_parts = NULL;
+    flying_grid = NULL;
+    flying_ents = NULL;
+    dep_forget_manifest(&FLYING_DEPS, REQ_ID_FLYING_HANDLER);
 
     // Shut down the game after this handler is complete.
     set_next_state(STATE_EXIT);
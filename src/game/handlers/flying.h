@@ -8,7 +8,35 @@
 #ifndef __CEEGEE_GAME_HANDLERS_FLYING__
 #define __CEEGEE_GAME_HANDLERS_FLYING__
 
+#include "src/gfx/deps/manager.h"
+
+// Maximum number of enemies and projectiles.
+#define FLYING_ENTS_MAX 1024
+// Distance beyond the edges of the screen at which entities are removed.
+#define FLYING_ENTS_MARGIN 64
+// Maximum number of bullet hits handled per tick.
+#define FLYING_HITS_MAX 256
+// Maximum number of particles.
+#define FLYING_PARTS_MAX 4096
+// Palette entries used for the engine exhaust. The ship's own
+// colors start at 236.
+#define EXHAUST_COLOR_FIRST 224
+#define EXHAUST_COLOR_N 8
+// Number of exhaust particles emitted per tick, and how long they last.
+#define EXHAUST_RATE 2
+#define EXHAUST_LIFE 32
+// Palette entries used for the background, just below the exhaust colors.
+#define BG_COLOR_FIRST 216
+#define BG_COLOR_N 8
+// Size of the background map in tiles, the number of different tiles,
+// and the speed at which the background scrolls in pixels per tick.
+#define FLYING_MAP_COLS 20
+#define FLYING_MAP_ROWS 64
+#define FLYING_TILES_N 8
+#define FLYING_SCROLL_SPEED 1
+
 extern int REQ_ID_FLYING_HANDLER;
+extern DEP_MANIFEST FLYING_DEPS;
 
 void flying_deps();
 void flying_init();
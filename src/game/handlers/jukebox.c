@@ -15,13 +15,19 @@
 #include "src/gfx/deps/manager.h"
 #include "src/gfx/deps/register.h"
 #include "src/gfx/modes.h"
+#include "src/gfx/palettes.h"
 #include "src/gfx/res/flim.h"
 #include "src/gfx/starfield/starfield.h"
 #include "src/gfx/text.h"
+#include "src/gfx/widgets.h"
 #include "src/utils/counters.h"
 
 int REQ_ID_JUKEBOX_HANDLER;
 
+// Dependencies of the jukebox handler.
+int *JUKEBOX_DEPS_RES[] = { &RES_ID_FLIM, NULL };
+DEP_MANIFEST JUKEBOX_DEPS = { JUKEBOX_DEPS_RES, NULL };
+
 // Track that's currently playing.
 struct song *curr_track;
 MIDI *curr_music;
@@ -50,6 +56,10 @@ int help_text_y4 = 0;
 int length, beats;
 int track_n = 0;
 
+// Text showing the current song, and its time and duration.
+TXT_WIDGET song_widget;
+TXT_WIDGET track_widget;
+
 /**
  * Draws two lines of help text on the screen to show the user
  * how to use the jukebox.
@@ -61,22 +71,36 @@ void draw_help(BITMAP *buffer) {
         TXT_REGULAR, TXT_CENTER, HELP_ARROWS);
 }
 
+/**
+ * Formats the text showing what song is currently playing.
+ */
+static void format_song_data(char txt[TXT_MAX_SIZE]) {
+    uszprintf(txt, TXT_MAX_SIZE, "%d/%d: %s", track_n + 1,
+        ALL_MUSIC_AMOUNT, curr_track->name);
+}
+
+/**
+ * Formats the current time and duration of the song.
+ */
+static void format_track_data(char txt[TXT_MAX_SIZE]) {
+    uszprintf(txt, TXT_MAX_SIZE, "%ld:%02ld/%d:%02d", midi_time / 60,
+        midi_time % 60, length / 60, length % 60);
+}
+
 /**
  * Updates the display to show what song is currently playing.
  */
 void update_song_data(BITMAP *buffer) {
-    draw_textf(buffer, help_text_x, help_text_y3, TXT_WHITE, -1, -1,
-        TXT_REGULAR, TXT_CENTER, "%d/%d: %s", track_n + 1,
-        ALL_MUSIC_AMOUNT, curr_track->name);
+    widget_draw(&song_widget, buffer);
 }
 
 /**
  * Draws the current time and duration of the song to the screen.
+ * The text is only formatted again when the time changes, which is
+ * once per second.
  */
 void update_track_data(BITMAP *buffer) {
-    draw_textf(buffer, help_text_x, help_text_y4, TXT_WHITE, -1, -1,
-        TXT_REGULAR, TXT_CENTER, "%ld:%02ld/%d:%02d", midi_time / 60,
-        midi_time % 60, length / 60, length % 60);
+    widget_draw(&track_widget, buffer);
 }
 
 /**
@@ -84,7 +108,7 @@ void update_track_data(BITMAP *buffer) {
  */
 void jukebox_deps() {
     REQ_ID_JUKEBOX_HANDLER = req_id();
-    dep_require(RES_ID_FLIM, REQ_ID_JUKEBOX_HANDLER);
+    dep_require_manifest(&JUKEBOX_DEPS, REQ_ID_JUKEBOX_HANDLER);
 }
 
 /**
@@ -98,7 +122,8 @@ void jukebox_init() {
     // Prepare for the jukebox loop.
     RGB *pal = get_starfield_palette();
     add_text_colors(pal);
-    set_palette(pal);
+    pal_set(pal);
+    start_starfield_cycle(pal);
     free(pal);
 
     initialize_starfield();
@@ -109,6 +134,15 @@ void jukebox_init() {
     help_text_y2 = SCREEN_H - (font_height * 4) - (font_height / 2);
     help_text_y3 = SCREEN_H - (font_height * 3);
     help_text_y4 = SCREEN_H - (font_height * 2);
+
+    widget_init(&song_widget, help_text_x, help_text_y3, TXT_WHITE, -1,
+        TXT_REGULAR, TXT_CENTER, format_song_data);
+    widget_bind(&song_widget, &track_n, sizeof(track_n));
+    widget_bind(&song_widget, &curr_track, sizeof(curr_track));
+    widget_init(&track_widget, help_text_x, help_text_y4, TXT_WHITE, -1,
+        TXT_REGULAR, TXT_CENTER, format_track_data);
+    widget_bind(&track_widget, &midi_time, sizeof(midi_time));
+    widget_bind(&track_widget, &length, sizeof(length));
 }
 
 /**
@@ -216,6 +250,9 @@ bool jukebox_will_exit() {
  * Shutdown and exit the jukebox handler.
  */
 void jukebox_exit() {
-    dep_forget(RES_ID_FLIM, REQ_ID_JUKEBOX_HANDLER);
+    widget_destroy(&song_widget);
+    widget_destroy(&track_widget);
+    pal_cycle_clear();
+    dep_forget_manifest(&JUKEBOX_DEPS, REQ_ID_JUKEBOX_HANDLER);
     set_next_state(STATE_EXIT);
 }
@@ -8,6 +8,8 @@
 #ifndef __CEEGEE_GAME_HANDLERS_JUKEBOX__
 #define __CEEGEE_GAME_HANDLERS_JUKEBOX__
 
+#include "src/gfx/deps/manager.h"
+
 #define JUKEBOX_EXIT 1
 #define JUKEBOX_NEXT_SONG 2
 #define JUKEBOX_PREV_SONG 3
@@ -18,6 +20,8 @@ void next_song();
 void draw_help();
 void update_song_data();
 void update_track_data();
+extern DEP_MANIFEST JUKEBOX_DEPS;
+
 void jukebox_deps();
 void jukebox_init();
 void jukebox_update();
@@ -5,10 +5,13 @@
 
 #include <allegro.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "src/audio/midi.h"
+#include "src/game/handlers/logos.h"
 #include "src/game/loop/state.h"
 #include "src/gfx/bitmaps.h"
+#include "src/gfx/palettes.h"
 #include "src/gfx/res/flim.h"
 #include "src/gfx/res/logos.h"
 #include "src/gfx/res/tin.h"
@@ -20,17 +23,40 @@
 int REQ_ID_LOGOS_HANDLER;
 DATAFILE* logos_data;
 
-// Fade speed. The speed goes from 1 (the slowest) up to 64 (instantaneous).
-const int FADE_SPEED = 5;
+// Dependencies of the logos handler. Only one full-screen logo is shown
+// at a time, so rather than requiring all of RES_ID_LAGAS, we require
+// the objects for the first logo only. The next logo is loaded in the
+// background while the first one is being shown.
+int *LOGOS_DEPS_RES[] = { &RES_ID_TIN, &RES_ID_FLIM, NULL };
+int LOGOS_DEPS_OBJS[] = { ASLOGO_IMG, ASLOGO_PALETTE, DEP_END };
+DEP_MANIFEST LOGOS_DEPS = { LOGOS_DEPS_RES, LOGOS_DEPS_OBJS };
+
+// Duration of the fades in milliseconds.
+const int FADE_MS = 200;
+
+// Which logo is being shown (0 or 1), the step it's at, and whether
+// it has been drawn yet.
+int logos_curr;
+int logos_step;
+bool logos_drawn;
 
 /**
  * Request the logos handler dependencies.
  */
 void logos_deps() {
     REQ_ID_LOGOS_HANDLER = req_id();
-    dep_require(RES_ID_TIN, REQ_ID_LOGOS_HANDLER);
-    dep_require(RES_ID_FLIM, REQ_ID_LOGOS_HANDLER);
-    dep_require(RES_ID_LAGAS, REQ_ID_LOGOS_HANDLER);
+    dep_require_manifest(&LOGOS_DEPS, REQ_ID_LOGOS_HANDLER);
+}
+
+/**
+ * Releases a logo once it's been shown. It's never shown again,
+ * so it's discarded right away rather than kept resident.
+ */
+static void release_logo(int img, int pal) {
+    dep_forget_obj(img, REQ_ID_LOGOS_HANDLER);
+    dep_forget_obj(pal, REQ_ID_LOGOS_HANDLER);
+    dep_discard_obj(img);
+    dep_discard_obj(pal);
 }
 
 /**
@@ -42,6 +68,23 @@ void logos_deps() {
  * shown, the handler exits.
  */
 void logos_init() {
+    logos_data = pack_ref();
+    logos_curr = 0;
+    logos_drawn = false;
+
+    // If the first logo couldn't be loaded, there's nothing to show.
+    if (!dep_ready_obj(ASLOGO_IMG) || !dep_ready_obj(ASLOGO_PALETTE)) {
+        logos_step = LOGOS_DONE;
+        return;
+    }
+
+    // We're going to draw text on top of the image,
+    // so add the text palette to the image.
+    add_text_colors(logos_data[ASLOGO_PALETTE].dat);
+
+    logos_step = LOGOS_FADE_IN;
+    pal_set(black_palette);
+
     // Play music, display logos and then shut down.
     music_start(&MUSIC_LOGOS);
 }
@@ -49,70 +92,143 @@ void logos_init() {
 /**
  * Update the internal state of the logos handler.
  *
- * Nothing happens here because there's no need to respond to any
- * user input.
+ * Moves the current logo on to its next step once its fade is done,
+ * or when a key is pressed while it's being shown. The fades themselves
+ * run in the background, so the game loop keeps running during them.
+ *
+ * The second logo starts loading in the background as soon as the first
+ * one is shown. By the time a key is pressed, it's usually there;
+ * if not, we wait for it with a loading bar.
  */
 void logos_update() {
+    switch (logos_step) {
+        case LOGOS_FADE_IN:
+            if (!logos_drawn || pal_fading()) {
+                break;
+            }
+            if (logos_curr == 0) {
+                dep_require_obj_async(TEST_IMG, REQ_ID_LOGOS_HANDLER);
+                dep_require_obj_async(TEST_PALETTE, REQ_ID_LOGOS_HANDLER);
+            }
+            logos_step = LOGOS_WAIT;
+            break;
+        case LOGOS_WAIT:
+            if (keypressed()) {
+                readkey();
+                pal_fade_out(FADE_MS);
+                logos_step = LOGOS_FADE_OUT;
+            }
+            break;
+        case LOGOS_FADE_OUT:
+            if (pal_fading()) {
+                break;
+            }
+            if (logos_curr == 1) {
+                logos_step = LOGOS_DONE;
+                break;
+            }
+            release_logo(ASLOGO_IMG, ASLOGO_PALETTE);
+            logos_curr = 1;
+            logos_drawn = false;
+            logos_step = LOGOS_LOADING;
+            // Fall through, since the next logo is probably loaded already.
+        case LOGOS_LOADING:
+            if (dep_ready_obj(TEST_IMG) && dep_ready_obj(TEST_PALETTE)) {
+                // The loading bar may be on the screen.
+                pal_set(black_palette);
+                logos_drawn = false;
+                logos_step = LOGOS_FADE_IN;
+            }
+            else if (dep_failed_obj(TEST_IMG) ||
+                dep_failed_obj(TEST_PALETTE)) {
+                logos_step = LOGOS_DONE;
+            }
+            break;
+    }
+}
+
+/**
+ * Renders the loading bar that's shown while waiting for the next logo.
+ * The screen is cleared and the text colors are set the first time,
+ * after that only the bar's progress is drawn.
+ */
+static void logos_render_loading(BITMAP *buffer) {
+    PALETTE pal;
+    int x = (SCREEN_W - LOGOS_BAR_W) / 2, y = (SCREEN_H - LOGOS_BAR_H) / 2;
+    int w = (LOGOS_BAR_W * dep_progress()) / 100;
+
+    if (!logos_drawn) {
+        clear_bitmap(buffer);
+        rect(buffer, x - 2, y - 2, x + LOGOS_BAR_W + 1, y + LOGOS_BAR_H + 1,
+            palette_color[253]);
+        memcpy(pal, black_palette, sizeof(PALETTE));
+        add_text_colors(pal);
+        pal_set(pal);
+        logos_drawn = true;
+    }
+    if (w > 0) {
+        rectfill(buffer, x, y, x + w - 1, y + LOGOS_BAR_H - 1,
+            palette_color[254]);
+    }
 }
 
 /**
  * Renders the output of the logos handler's current game state.
  *
- * The drawing routines are all blocking, meaning one "frame" is enough
- * to fade all logos in and out.
+ * Each logo is drawn once, while the palette is black, after which
+ * it's faded in. The screen doesn't change until the next logo,
+ * except for the loading bar if we have to wait for it.
  */
 void logos_render(BITMAP *buffer) {
-    logos_data = dep_data_ref(RES_ID_LAGAS);
-
-    // We're going to draw text on top of the image,
-    // so add the text palette to the image.
-    add_text_colors(logos_data[ASLOGO_PALETTE].dat);
+    if (logos_step == LOGOS_LOADING) {
+        logos_render_loading(buffer);
+        return;
+    }
+    if (logos_drawn || logos_step != LOGOS_FADE_IN) {
+        return;
+    }
 
-    // Display the main logo with text drawn on top.
-    set_palette(black_palette);
-    blit(logos_data[ASLOGO_IMG].dat, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
-    draw_text(screen, 160, 154, TXT_WHITE, -1, -1,
-        TXT_REGULAR, TXT_CENTER, "(C) 2016, Avalanche Studios");
-    draw_text(screen, 160, 154 + FLIM_HEIGHT + 2, TXT_WHITE, -1, -1,
-        TXT_REGULAR, TXT_CENTER, "www.avalanchestudios.net");
-    if (DEBUG) {
-        draw_text(screen, 160, 154 + FLIM_HEIGHT + 18, TXT_GRAY, -1, -1,
-            TXT_SMALL, TXT_CENTER, (char *)get_short_version());
+    if (logos_curr == 0) {
+        // Display the main logo with text drawn on top.
+        blit(
+            logos_data[ASLOGO_IMG].dat, buffer, 0, 0, 0, 0, SCREEN_W, SCREEN_H
+        );
+        draw_text(buffer, 160, 154, TXT_WHITE, -1, -1,
+            TXT_REGULAR, TXT_CENTER, "(C) 2016, Avalanche Studios");
+        draw_text(buffer, 160, 154 + FLIM_HEIGHT + 2, TXT_WHITE, -1, -1,
+            TXT_REGULAR, TXT_CENTER, "www.avalanchestudios.net");
+        if (DEBUG) {
+            draw_text(buffer, 160, 154 + FLIM_HEIGHT + 18, TXT_GRAY, -1, -1,
+                TXT_SMALL, TXT_CENTER, (char *)get_short_version());
+        }
+        pal_fade_to(logos_data[ASLOGO_PALETTE].dat, FADE_MS);
+    }
+    else {
+        blit(logos_data[TEST_IMG].dat, buffer, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
+        pal_fade_to(logos_data[TEST_PALETTE].dat, FADE_MS);
     }
-    fade_from(black_palette, logos_data[ASLOGO_PALETTE].dat, FADE_SPEED);
-
-    // Wait for any key, then draw the second logo.
-    readkey();
-    fade_out(FADE_SPEED);
-    set_palette(black_palette);
-    blit(logos_data[TEST_IMG].dat, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
-    fade_from(black_palette, logos_data[TEST_PALETTE].dat, FADE_SPEED);
-
-    // Wait for any key, then finish. This handler immediately exits
-    // after running the logos_render() function once, so this code
-    // is guaranteed to only run once.
-    readkey();
-    fade_out(FADE_SPEED);
+    logos_drawn = true;
 }
 
 /**
  * Whether or not the logos handler will shutdown and exit.
  *
- * Since all rendering we do is blocking, we can immediately exit
- * after doing a single logos_render() call, which is guaranteed
- * to happen at least once.
+ * This happens once the last logo has faded out.
  */
 bool logos_will_exit() {
-    return true;
+    return logos_step == LOGOS_DONE;
 }
 
 /**
  * Shutdown and exit the logos handler.
  */
 void logos_exit() {
-    dep_forget(RES_ID_TIN, REQ_ID_LOGOS_HANDLER);
-    dep_forget(RES_ID_FLIM, REQ_ID_LOGOS_HANDLER);
-    dep_forget(RES_ID_LAGAS, REQ_ID_LOGOS_HANDLER);
+    // The first logo was already released before the second one was shown.
+    dep_forget_manifest(&LOGOS_DEPS, REQ_ID_LOGOS_HANDLER);
+    dep_forget_obj(TEST_IMG, REQ_ID_LOGOS_HANDLER);
+    dep_forget_obj(TEST_PALETTE, REQ_ID_LOGOS_HANDLER);
+    dep_discard_obj(TEST_IMG);
+    dep_discard_obj(TEST_PALETTE);
     music_stop();
     set_next_state(STATE_FLYING);
 }
@@ -8,6 +8,23 @@
 #ifndef __CEEGEE_GAME_HANDLERS_LOGOS__
 #define __CEEGEE_GAME_HANDLERS_LOGOS__
 
+#include "src/gfx/deps/manager.h"
+
+// Steps every logo goes through: it fades in, waits for a key,
+// and fades out. If the next logo isn't loaded yet by then, a loading bar
+// is shown until it is. After the last logo, the handler is done.
+#define LOGOS_FADE_IN 0
+#define LOGOS_WAIT 1
+#define LOGOS_FADE_OUT 2
+#define LOGOS_LOADING 3
+#define LOGOS_DONE 4
+
+// Size of the loading bar, in pixels.
+#define LOGOS_BAR_W 128
+#define LOGOS_BAR_H 4
+
+extern DEP_MANIFEST LOGOS_DEPS;
+
 void logos_deps();
 void logos_init();
 void logos_update();
@@ -13,6 +13,8 @@
 #include "src/game/handlers/logos.h"
 #include "src/game/handlers/jukebox.h"
 #include "src/game/loop/state.h"
+#include "src/gfx/deps/manager.h"
+#include "src/gfx/palettes.h"
 
 // Whether the game loop will exit.
 bool game_loop_exit = FALSE;
@@ -123,6 +125,8 @@ bool game_loop_will_exit() {
  * When exiting the outer game loop, the game itself is shut down.
  */
 void game_loop() {
+    bool first_frame;
+
     while (!game_loop_exit) {
         // Determine which handler to use. This sets all variables
         // ending in _ptr to the appropriate handler functions.
@@ -133,17 +137,29 @@ void game_loop() {
         handler_init_ptr();
 
         // Start the handler's own loop. Run update(), vsync() and render(),
-        // until the handler asks to be terminated.
+        // until the handler asks to be terminated. Any resources that are
+        // being loaded in the background get a bit of time every frame.
+        // Palette fades are advanced during the vertical retrace.
+        // The transition to this handler ends once its first frame is on
+        // the screen, so that the time spent preparing it is included.
         handler_exit = false;
+        first_frame = true;
         while (!handler_exit) {
+            dep_update();
             handler_update_ptr();
             vsync();
+            pal_update();
             handler_render_ptr(screen);
+            if (first_frame) {
+                dep_end_transition(get_curr_state());
+                first_frame = false;
+            }
             handler_exit = handler_will_exit_ptr();
         }
 
         // Ask the handler to shut itself down and deallocate any
         // resources we don't need anymore.
+        dep_begin_transition();
         handler_exit_ptr();
 
         // Advance to the next game state.
@@ -7,6 +7,7 @@
 #include <stdbool.h>
 
 #include "src/game/sprites/ships.h"
+#include "src/gfx/batch.h"
 #include "src/gfx/res/usp_talon.h"
 #include "src/gfx/modes.h"
 
@@ -16,9 +17,9 @@ int scr_boundary_y = CEEGEE_SCR_H;
 /**
  * Creates and returns a new ship instance.
  *
- * Requires a reference to a datafile for initializing the ship's graphics.
+ * The ship's resource must be loaded, since its frames are used.
  */
-SHIP ship_create(int type, DATAFILE* ship_data) {
+SHIP ship_create(int type) {
     SHIP inst;
     switch (type) {
         case USP_TALON:
@@ -26,14 +27,14 @@ SHIP ship_create(int type, DATAFILE* ship_data) {
             inst.x = 0;
             inst.y = 0;
             inst.pivot = PIVOT_CENTER;
-            inst.cspr_m = (COMPILED_SPRITE *)ship_data[USP_TALON_M].dat;
-            inst.cspr_l1 = (COMPILED_SPRITE *)ship_data[USP_TALON_L1].dat;
-            inst.cspr_l2 = (COMPILED_SPRITE *)ship_data[USP_TALON_L2].dat;
-            inst.cspr_r1 = (COMPILED_SPRITE *)ship_data[USP_TALON_R1].dat;
-            inst.cspr_r2 = (COMPILED_SPRITE *)ship_data[USP_TALON_R2].dat;
-            inst.curr_frame = &inst.cspr_m;
-            inst.w = inst.cspr_m->w;
-            inst.h = inst.cspr_m->h;
+            inst.spr_m = USP_TALON_FRAMES[USP_TALON_FRAME_M];
+            inst.spr_l1 = USP_TALON_FRAMES[USP_TALON_FRAME_L1];
+            inst.spr_l2 = USP_TALON_FRAMES[USP_TALON_FRAME_L2];
+            inst.spr_r1 = USP_TALON_FRAMES[USP_TALON_FRAME_R1];
+            inst.spr_r2 = USP_TALON_FRAMES[USP_TALON_FRAME_R2];
+            inst.curr_frame = &inst.spr_m;
+            inst.w = inst.spr_m->w;
+            inst.h = inst.spr_m->h;
             return inst;
     }
 }
@@ -47,10 +48,10 @@ void ship_set_pos(SHIP *ship, int x, int y) {
 }
 
 /**
- * Draws a ship onto a buffer.
+ * Submits a ship to the sprite batch. It's drawn when the batch ends.
  */
-void ship_draw(SHIP *ship, BITMAP *buffer) {
-    draw_compiled_sprite(buffer, *ship->curr_frame, ship->x, ship->y);
+void ship_draw(SHIP *ship) {
+    batch_add(*ship->curr_frame, ship->x, ship->y, LAYER_SHIPS);
 }
 
 /**
@@ -99,19 +100,19 @@ void ship_set_pivot(SHIP *ship) {
     int frame = ship->pivot / PIVOT_DIVIDER;
     switch (frame) {
         case 0:
-            ship->curr_frame = &ship->cspr_l2;
+            ship->curr_frame = &ship->spr_l2;
             break;
         case 1:
-            ship->curr_frame = &ship->cspr_l1;
+            ship->curr_frame = &ship->spr_l1;
             break;
         case 2:
-            ship->curr_frame = &ship->cspr_m;
+            ship->curr_frame = &ship->spr_m;
             break;
         case 3:
-            ship->curr_frame = &ship->cspr_r1;
+            ship->curr_frame = &ship->spr_r1;
             break;
         case 4:
-            ship->curr_frame = &ship->cspr_r2;
+            ship->curr_frame = &ship->spr_r2;
             break;
     }
 }
@@ -119,7 +120,9 @@ void ship_set_pivot(SHIP *ship) {
 /**
  * Limits the ship's x and y positions to buffer boundaries.
  * Should be called whenever updating the x and y positions
- * of the ship.
+ * of the ship. This only keeps the player on the playfield; drawing
+ * doesn't depend on it, since the sprite batch clips sprites that
+ * are partially off-screen.
  */
 void ship_limit_boundaries(SHIP *ship) {
     if (ship->x < 0) {
@@ -9,6 +9,8 @@
 #ifndef __CEEGEE_GAME_SHIPS_USP_TALON__
 #define __CEEGEE_GAME_SHIPS_USP_TALON__
 
+#include "src/gfx/frames.h"
+
 #define USP_TALON 1
 
 #define PIVOT_MAX 319
@@ -19,12 +21,12 @@
 typedef struct SHIP {
     int x, y, w, h;
     int pivot;
-    COMPILED_SPRITE *cspr_m, *cspr_l1, *cspr_l2, *cspr_r1, *cspr_r2;
-    COMPILED_SPRITE **curr_frame;
+    SPR_FRAME *spr_m, *spr_l1, *spr_l2, *spr_r1, *spr_r2;
+    SPR_FRAME **curr_frame;
 } SHIP;
 
 SHIP ship_create();
-void ship_draw(SHIP *ship, BITMAP *buffer);
+void ship_draw(SHIP *ship);
 void ship_feed_input(SHIP *ship);
 void ship_limit_boundaries(SHIP *ship);
 void ship_set_pivot(SHIP *ship);
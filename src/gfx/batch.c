@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "src/gfx/batch.h"
+
+// Sprites submitted this frame, in submission order, and their layers.
+BATCH_ITEM batch_items[BATCH_MAX];
+unsigned char batch_layers[BATCH_MAX];
+// The same sprites sorted by layer, filled in by batch_end().
+BATCH_ITEM batch_sorted[BATCH_MAX];
+// Number of sprites submitted to each layer this frame.
+int batch_layer_n[BATCH_LAYERS];
+int batch_n = 0;
+
+// The buffer being drawn to, and its clip rectangle. The rectangle is
+// read once per frame; cr and cb are exclusive, as in Allegro's BITMAP.
+// The buffer is NULL when no batch is open.
+BITMAP *batch_buffer = NULL;
+int batch_cl, batch_ct, batch_cr, batch_cb;
+
+// Counters for the frame being built, and for the last one drawn.
+BATCH_STATS batch_curr;
+BATCH_STATS batch_last;
+
+/**
+ * Starts a new frame. Sprites submitted with batch_add() are drawn
+ * onto the buffer when batch_end() is called.
+ */
+void batch_begin(BITMAP *buffer) {
+    int a;
+
+    batch_buffer = buffer;
+    batch_n = 0;
+    for (a = 0; a < BATCH_LAYERS; ++a) {
+        batch_layer_n[a] = 0;
+    }
+    batch_curr.submitted = 0;
+    batch_curr.culled = 0;
+    batch_curr.dropped = 0;
+    batch_curr.drawn = 0;
+    batch_curr.compiled = 0;
+
+    if (buffer->clip) {
+        batch_cl = buffer->cl;
+        batch_ct = buffer->ct;
+        batch_cr = buffer->cr;
+        batch_cb = buffer->cb;
+    }
+    else {
+        batch_cl = 0;
+        batch_ct = 0;
+        batch_cr = buffer->w;
+        batch_cb = buffer->h;
+    }
+}
+
+/**
+ * Submits a sprite to be drawn this frame. Sprites that are entirely
+ * outside of the buffer's clip rectangle are culled right away.
+ * Sprites submitted outside of batch_begin() and batch_end() are ignored,
+ * since there's no clip rectangle to check them against.
+ */
+void batch_add(SPR_FRAME *frame, int x, int y, int layer) {
+    BATCH_ITEM *item;
+
+    if (!batch_buffer) {
+        return;
+    }
+    batch_curr.submitted += 1;
+    if (x >= batch_cr || y >= batch_cb ||
+        x + frame->w <= batch_cl || y + frame->h <= batch_ct) {
+        batch_curr.culled += 1;
+        return;
+    }
+    if (batch_n == BATCH_MAX) {
+        batch_curr.dropped += 1;
+        return;
+    }
+    layer = MID(0, layer, BATCH_LAYERS - 1);
+    item = &batch_items[batch_n];
+    item->frame = frame;
+    item->x = x;
+    item->y = y;
+    item->inside = x >= batch_cl && y >= batch_ct &&
+        x + frame->w <= batch_cr && y + frame->h <= batch_cb;
+    batch_layers[batch_n] = layer;
+    batch_layer_n[layer] += 1;
+    batch_n += 1;
+}
+
+/**
+ * Sorts the submitted sprites by layer and draws them. Since there are
+ * only a few layers, this is a counting sort: the start of each layer
+ * in the sorted list is the sum of the sizes of the layers before it.
+ * The sort is stable, so sprites on the same layer keep their order.
+ *
+ * Sprites that are entirely inside the clip rectangle are drawn using
+ * their compiled version. Compiled sprites can't be clipped, so sprites
+ * that are partially outside of it are drawn as RLE sprites instead.
+ */
+void batch_end() {
+    int start[BATCH_LAYERS];
+    BATCH_ITEM *item;
+    int a, pos = 0;
+
+    if (!batch_buffer) {
+        return;
+    }
+    for (a = 0; a < BATCH_LAYERS; ++a) {
+        start[a] = pos;
+        pos += batch_layer_n[a];
+    }
+    for (a = 0; a < batch_n; ++a) {
+        batch_sorted[start[batch_layers[a]]++] = batch_items[a];
+    }
+
+    acquire_bitmap(batch_buffer);
+    for (a = 0; a < batch_n; ++a) {
+        item = &batch_sorted[a];
+        if (item->inside && item->frame->cspr) {
+            draw_compiled_sprite(
+                batch_buffer, item->frame->cspr, item->x, item->y
+            );
+            batch_curr.compiled += 1;
+        }
+        else {
+            draw_rle_sprite(batch_buffer, item->frame->rle, item->x, item->y);
+        }
+    }
+    release_bitmap(batch_buffer);
+
+    batch_curr.drawn = batch_n;
+    batch_last = batch_curr;
+    batch_buffer = NULL;
+    batch_n = 0;
+}
+
+/**
+ * Returns the counters of the last frame that was drawn.
+ */
+BATCH_STATS *batch_stats() {
+    return &batch_last;
+}
+
+/**
+ * Prints the counters of the last frame that was drawn.
+ */
+void debug_batch_stats(FILE *out) {
+    fprintf(
+        out,
+        "Sprite batch: %d submitted, %d culled, %d dropped, %d drawn "
+        "(%d compiled)\n",
+        batch_last.submitted,
+        batch_last.culled,
+        batch_last.dropped,
+        batch_last.drawn,
+        batch_last.compiled
+    );
+}
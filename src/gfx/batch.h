@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#ifndef __CEEGEE_GFX_BATCH__
+#define __CEEGEE_GFX_BATCH__
+
+#include "src/gfx/frames.h"
+
+// Maximum number of sprites that can be submitted per frame.
+// Sprites submitted after the batch is full are dropped.
+#define BATCH_MAX 1024
+// Number of layers. Layer 0 is drawn first, i.e. furthest back.
+#define BATCH_LAYERS 8
+
+// Layers used by the game. Sprites on the same layer are drawn
+// in the order in which they were submitted.
+#define LAYER_BACKGROUND 0
+#define LAYER_EFFECTS_LOW 2
+#define LAYER_ENEMIES 3
+#define LAYER_SHIPS 4
+#define LAYER_BULLETS 5
+#define LAYER_EFFECTS_HIGH 6
+#define LAYER_HUD 7
+
+// A sprite submitted to the batch. inside is set if the sprite is
+// entirely inside the clip rectangle, so it doesn't need to be clipped.
+typedef struct BATCH_ITEM {
+    SPR_FRAME *frame;
+    int x, y;
+    bool inside;
+} BATCH_ITEM;
+
+// Counters for the last frame that was drawn. Culled sprites were
+// entirely outside the clip rectangle; dropped ones didn't fit.
+// Of the sprites that were drawn, compiled ones were drawn as
+// compiled sprites, and the rest as clipped RLE sprites.
+typedef struct BATCH_STATS {
+    int submitted;
+    int culled;
+    int dropped;
+    int drawn;
+    int compiled;
+} BATCH_STATS;
+
+BATCH_STATS *batch_stats();
+void batch_add(SPR_FRAME *frame, int x, int y, int layer);
+void batch_begin(BITMAP *buffer);
+void batch_end();
+void debug_batch_stats(FILE *out);
+
+#endif
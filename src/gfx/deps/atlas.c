@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdio.h>
+
+#include "src/gfx/deps/atlas.h"
+#include "src/gfx/deps/pack.h"
+
+/**
+ * Loads an ATL object from the pack and returns it as a SPR_ATLAS.
+ *
+ * The object starts with the number of frames (16 bits), followed by the
+ * width and height (16 bits each) and RLE data size (32 bits) of every
+ * frame. Then comes the RLE data of all frames, in order. The data is
+ * already in Allegro's 8-bit RLE format, so it's read straight into place.
+ * Everything is put in one allocation, so the frames are next to each
+ * other in memory.
+ */
+static void *load_atlas(PACKFILE *f, long size) {
+    SPR_ATLAS *atlas;
+    RLE_SPRITE *frame;
+    int w[ATLAS_FRAMES_MAX], h[ATLAS_FRAMES_MAX];
+    long len[ATLAS_FRAMES_MAX];
+    long total;
+    char *pos;
+    int a, n;
+
+    n = pack_igetw(f);
+    if (n <= 0 || n > ATLAS_FRAMES_MAX) {
+        return NULL;
+    }
+    total = ATLAS_ALIGN(sizeof(SPR_ATLAS) + n * sizeof(RLE_SPRITE *));
+    for (a = 0; a < n; ++a) {
+        w[a] = pack_igetw(f);
+        h[a] = pack_igetw(f);
+        len[a] = pack_igetl(f);
+        if (w[a] <= 0 || h[a] <= 0 || len[a] <= 0) {
+            return NULL;
+        }
+        total += ATLAS_ALIGN(sizeof(RLE_SPRITE) + len[a]);
+    }
+
+    atlas = malloc(total);
+    if (!atlas) {
+        return NULL;
+    }
+    atlas->n = n;
+    atlas->size = total;
+    atlas->frames = (RLE_SPRITE **)(atlas + 1);
+    pos = (char *)atlas +
+        ATLAS_ALIGN(sizeof(SPR_ATLAS) + n * sizeof(RLE_SPRITE *));
+    for (a = 0; a < n; ++a) {
+        frame = (RLE_SPRITE *)pos;
+        frame->w = w[a];
+        frame->h = h[a];
+        frame->color_depth = 8;
+        frame->size = len[a];
+        if (pack_fread(frame->dat, len[a], f) != len[a]) {
+            free(atlas);
+            return NULL;
+        }
+        atlas->frames[a] = frame;
+        pos += ATLAS_ALIGN(sizeof(RLE_SPRITE) + len[a]);
+    }
+    return atlas;
+}
+
+/**
+ * Frees an ATL object. The frames are part of the same block.
+ */
+static void destroy_atlas(void *data) {
+    free(data);
+}
+
+/**
+ * Lets Allegro load ATL objects from datafiles, and lets the pack read
+ * them in parts. Must be called before any objects are loaded from
+ * the pack.
+ */
+void atlas_register() {
+    register_datafile_object(DAT_ATLAS, load_atlas, destroy_atlas);
+    pack_register_type(DAT_ATLAS, load_atlas);
+}
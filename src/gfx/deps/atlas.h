@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+
+#ifndef __CEEGEE_GFX_DEPS_ATLAS__
+#define __CEEGEE_GFX_DEPS_ATLAS__
+
+// Datafile object type for sprite atlases baked by tools/atlasbake.
+#define DAT_ATLAS DAT_ID('A', 'T', 'L', ' ')
+
+// Maximum number of frames in an atlas.
+#define ATLAS_FRAMES_MAX 256
+// Frames are placed at multiples of this many bytes inside the atlas.
+#define ATLAS_ALIGN(n) (((n) + 7) & ~7)
+
+// A number of RLE sprites, e.g. the animation frames of a ship, stored in
+// a single block of memory. The block starts with this struct, followed by
+// the frame table and then the frames themselves, in order. size is the
+// size of the whole block. Note that on-screen frames are mostly drawn from
+// their compiled versions, which are kept elsewhere; see SPR_FRAME.
+typedef struct SPR_ATLAS {
+    int n;
+    long size;
+    RLE_SPRITE **frames;
+} SPR_ATLAS;
+
+static void *load_atlas(PACKFILE *f, long size);
+static void destroy_atlas(void *data);
+void atlas_register();
+
+#endif
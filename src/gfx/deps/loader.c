@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "src/gfx/deps/loader.h"
+#include "src/gfx/deps/pack.h"
+
+/**
+ * Loads the next object from the pack in one go. Returns false if the
+ * object couldn't be loaded.
+ */
+static bool load_next_object(CGLOADER *loader) {
+    if (!pack_load_obj(loader->objs[loader->done])) {
+        loader->failed = true;
+        return false;
+    }
+    loader->done += 1;
+    return true;
+}
+
+/**
+ * Reads up to max bytes of the next object, where max is what's left of
+ * the current step. Once all of its data has been read, the object is made
+ * out of it at the start of the next step; that counts as a whole step.
+ * Objects that can't be read in parts are loaded in one go; these are
+ * only small things like palettes and fonts.
+ * Returns the amount of work done, in bytes, or -1 if loading failed.
+ */
+static long read_next_object(CGLOADER *loader, long max) {
+    int obj = loader->objs[loader->done];
+    long n;
+
+    if (!loader->reading) {
+        // If the object is already loaded, it only gets another reference.
+        if (pack_obj_loaded(obj)) {
+            return load_next_object(loader) ? 0 : -1;
+        }
+        if (!pack_read_begin(&loader->read, obj)) {
+            return load_next_object(loader) ? pack_ref()[obj].size : -1;
+        }
+        loader->reading = true;
+    }
+
+    n = pack_read_step(&loader->read, max);
+    if (n < 0) {
+        pack_read_abort(&loader->read);
+        loader->reading = false;
+        loader->failed = true;
+        return -1;
+    }
+    if (n > 0) {
+        return n;
+    }
+    if (max < LOADER_STEP_BYTES) {
+        return max;
+    }
+
+    loader->reading = false;
+    if (!pack_read_end(&loader->read)) {
+        loader->failed = true;
+        return -1;
+    }
+    loader->done += 1;
+    return max;
+}
+
+/**
+ * Starts loading a list of pack objects incrementally. Call loader_step()
+ * once per frame until it returns true, then call loader_finish().
+ * Returns NULL if there isn't enough memory.
+ */
+CGLOADER *loader_start(int *objs, int count) {
+    CGLOADER *loader = malloc(sizeof(CGLOADER));
+
+    if (!loader) {
+        return NULL;
+    }
+    loader->objs = objs;
+    loader->total = count;
+    loader->done = 0;
+    loader->finished = false;
+    loader->failed = false;
+    loader->reading = false;
+    return loader;
+}
+
+/**
+ * Performs a bounded amount of loading work: reads at most
+ * LOADER_STEP_BYTES from the pack, or makes one object out of the data
+ * that was read during the previous steps. Large objects are read
+ * over several steps.
+ *
+ * Returns true when loading is finished.
+ */
+bool loader_step(CGLOADER *loader) {
+    long n, bytes = 0;
+
+    if (loader->finished) {
+        return true;
+    }
+    while (loader->done < loader->total && bytes < LOADER_STEP_BYTES) {
+        n = read_next_object(loader, LOADER_STEP_BYTES - bytes);
+        if (n < 0) {
+            break;
+        }
+        bytes += n;
+    }
+    if (loader->done == loader->total || loader->failed) {
+        loader->finished = true;
+    }
+    return loader->finished;
+}
+
+/**
+ * Returns the loading progress as a percentage. The object that's being
+ * read in parts counts for as much of it as has been read.
+ */
+int loader_progress(CGLOADER *loader) {
+    int part = 0;
+
+    if (loader->total == 0) {
+        return 100;
+    }
+    if (loader->reading && loader->read.size > 0) {
+        part = (loader->read.pos * 100) / loader->read.size;
+    }
+    return (loader->done * 100 + part) / loader->total;
+}
+
+/**
+ * Frees the loader itself, but not the objects it loaded.
+ */
+static void loader_destroy(CGLOADER *loader) {
+    if (loader->reading) {
+        pack_read_abort(&loader->read);
+    }
+    free(loader);
+}
+
+/**
+ * Unloads the objects that were loaded so far.
+ */
+static void loader_unload(CGLOADER *loader) {
+    int a;
+
+    for (a = 0; a < loader->done; ++a) {
+        pack_unload_obj(loader->objs[a]);
+    }
+}
+
+/**
+ * Completes loading, blocking if necessary. The loader is freed afterwards.
+ * Returns false if loading failed, in which case nothing stays loaded.
+ */
+bool loader_finish(CGLOADER *loader) {
+    bool success;
+
+    while (!loader_step(loader)) {
+        // Every step does a bounded amount of work.
+    }
+
+    success = !loader->failed;
+    if (!success) {
+        loader_unload(loader);
+    }
+    loader_destroy(loader);
+    return success;
+}
+
+/**
+ * Stops loading and unloads everything that was loaded so far.
+ */
+void loader_abort(CGLOADER *loader) {
+    loader_unload(loader);
+    loader_destroy(loader);
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GFX_DEPS_LOADER__
+#define __CEEGEE_GFX_DEPS_LOADER__
+
+#include "src/gfx/deps/pack.h"
+
+// Maximum number of bytes read from the pack per loader_step().
+// Making an object out of its data is done in a step of its own.
+#define LOADER_STEP_BYTES 16384
+
+// CGLOADER (CeeGee loader) object. Loads a list of pack objects
+// one at a time. Loading is complete once done == total,
+// at which point finished is set. If reading is set, the next object
+// is being read in parts through read.
+typedef struct CGLOADER {
+    int *objs;
+    int total;
+    int done;
+    bool finished;
+    bool failed;
+    bool reading;
+    PACK_READ read;
+} CGLOADER;
+
+CGLOADER *loader_start(int *objs, int count);
+bool loader_finish(CGLOADER *loader);
+bool loader_step(CGLOADER *loader);
+int loader_progress(CGLOADER *loader);
+static bool load_next_object(CGLOADER *loader);
+static long read_next_object(CGLOADER *loader, long max);
+static void loader_destroy(CGLOADER *loader);
+static void loader_unload(CGLOADER *loader);
+void loader_abort(CGLOADER *loader);
+
+#endif
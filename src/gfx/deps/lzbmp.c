@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdio.h>
+
+#include "src/gfx/deps/lzbmp.h"
+#include "src/gfx/deps/pack.h"
+#include "src/utils/lz4.h"
+
+/**
+ * Loads an LZB object from the pack and returns it as a BITMAP.
+ *
+ * The object starts with the bitmap's width and height (16 bits each),
+ * the storage method and the number of bytes that follow (32 bits).
+ * The pixels are either stored as-is, or compressed as one LZ4 block.
+ * tools/lzbake picks the method per image when the pack is built.
+ */
+static void *load_lzbmp(PACKFILE *f, long size) {
+    BITMAP *bmp;
+    unsigned char *buf;
+    int w, h, method;
+    long len;
+
+    w = pack_igetw(f);
+    h = pack_igetw(f);
+    method = pack_getc(f);
+    len = pack_igetl(f);
+    if (w <= 0 || h <= 0 || len <= 0) {
+        return NULL;
+    }
+    // Anything else is corrupt, or made by a newer version of the tool.
+    if (method != LZBMP_STORED && method != LZBMP_LZ4) {
+        return NULL;
+    }
+
+    bmp = create_bitmap_ex(8, w, h);
+    if (!bmp) {
+        return NULL;
+    }
+
+    // Memory bitmaps are contiguous, so we can write straight to line[0].
+    if (method == LZBMP_STORED) {
+        if (len != (long)w * h || pack_fread(bmp->line[0], len, f) != len) {
+            destroy_bitmap(bmp);
+            return NULL;
+        }
+        return bmp;
+    }
+
+    buf = malloc(len);
+    if (!buf || pack_fread(buf, len, f) != len ||
+        lz4_decompress(buf, len, bmp->line[0], w * h) != w * h) {
+        free(buf);
+        destroy_bitmap(bmp);
+        return NULL;
+    }
+    free(buf);
+    return bmp;
+}
+
+/**
+ * Frees an LZB object.
+ */
+static void destroy_lzbmp(void *data) {
+    if (data) {
+        destroy_bitmap(data);
+    }
+}
+
+/**
+ * Lets Allegro load LZB objects from datafiles, and lets the pack read
+ * them in parts. Must be called before any objects are loaded from
+ * the pack.
+ */
+void lzbmp_register() {
+    register_datafile_object(DAT_LZBMP, load_lzbmp, destroy_lzbmp);
+    pack_register_type(DAT_LZBMP, load_lzbmp);
+}
@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+
+#ifndef __CEEGEE_GFX_DEPS_LZBMP__
+#define __CEEGEE_GFX_DEPS_LZBMP__
+
+// Datafile object type for 8-bit bitmaps baked by tools/lzbake.
+// Once loaded, these are regular BITMAP objects.
+#define DAT_LZBMP DAT_ID('L', 'Z', 'B', ' ')
+
+// How the pixels of an LZB object are stored.
+#define LZBMP_STORED 0
+#define LZBMP_LZ4 1
+
+static void *load_lzbmp(PACKFILE *f, long size);
+static void destroy_lzbmp(void *data);
+void lzbmp_register();
+
+#endif
@@ -7,78 +7,622 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <time.h>
 
+#include "src/gfx/deps/atlas.h"
+#include "src/gfx/deps/lzbmp.h"
 #include "src/gfx/deps/manager.h"
+#include "src/gfx/deps/pack.h"
+#include "src/gfx/glyphs.h"
+#include "src/utils/counters.h"
 
-// List of actively loaded resources.
-int active_res[1000];
-// List of resources we want to load.
-int load_res[1000];
-// List of resources we no longer need.
-int unload_res[1000];
-// List of resources that can be requested.
-CGRES* res_list[1000];
-// Callback functions.
-void (*res_cb[1000])();
+// Table of all resources that can be requested. Grows as needed.
+// Free slots are linked together through their next_free field.
+RES_SLOT *res_slots = NULL;
+int res_slot_count = 0;
+int res_free_slot = -1;
+
+// Total number of datafile loads, and of requests that could and couldn't
+// be served from memory, across all resources.
+int res_total_loads = 0;
+int res_total_hits = 0;
+int res_total_misses = 0;
+// Total number of resources that were evicted from the resident pool.
+int res_total_evictions = 0;
+// Number of times an invalid or stale resource handle was used.
+int res_total_stale = 0;
+
+// Resident pool of resources that have no owners, but are kept in memory
+// in case someone needs them again. The head is the most recently released
+// resource, the tail is the first one to be evicted.
+CGRES *pool_head = NULL;
+CGRES *pool_tail = NULL;
+// Number of resources that are currently being loaded incrementally.
+int res_loading = 0;
+
+// Resources that were automatically registered for single pack objects,
+// and the object indices they use as their object list.
+int *obj_res = NULL;
+int *obj_ids = NULL;
+
+// Number of bytes currently held by the pool, and the maximum.
+long pool_size = 0;
+long pool_budget = RES_POOL_BUDGET;
+
+// How long it took for each handler to become ready, from the moment the
+// previous handler exited until the new one's first frame. The first
+// handler is timed from program startup.
+int res_trans_states[RES_TRANSITIONS_MAX];
+long res_trans_ms[RES_TRANSITIONS_MAX];
+int res_trans_count = 0;
+clock_t res_trans_start = 0;
+
+// Object types that get their own column in the resource report.
+// Anything else is counted under the last name.
+int RES_REPORT_TYPE_IDS[RES_REPORT_TYPES] = {
+    DAT_BITMAP, DAT_RLE_SPRITE, DAT_C_SPRITE, DAT_PALETTE, DAT_FONT
+};
+char *RES_REPORT_TYPE_NAMES[RES_REPORT_TYPES + 1] = {
+    "BMP", "RLE", "CMP", "PAL", "FONT", "other"
+};
+
+/**
+ * Prints the owners of a resource as a comma separated list.
+ */
+static void print_owners(FILE *out, CGRES *item) {
+    int a;
+    bool lstart = FALSE;
+
+    for (a = 0; a < item->own_words * 32; ++a) {
+        if (item->own_bits[a / 32] & (1u << (a % 32))) {
+            if (lstart) {
+                fprintf(out, ",");
+            }
+            fprintf(out, "%i", a);
+            lstart = TRUE;
+        }
+    }
+}
+
+/**
+ * Returns the column of a datafile object type in the resource report.
+ */
+static int res_type_index(int type) {
+    int a;
+
+    // Baked bitmaps are regular bitmaps once they're loaded,
+    // atlases are made up of RLE sprites and glyph sets are fonts.
+    if (type == DAT_LZBMP) {
+        type = DAT_BITMAP;
+    }
+    if (type == DAT_ATLAS) {
+        type = DAT_RLE_SPRITE;
+    }
+    if (type == DAT_GLYPHS) {
+        type = DAT_FONT;
+    }
+    for (a = 0; a < RES_REPORT_TYPES; ++a) {
+        if (RES_REPORT_TYPE_IDS[a] == type) {
+            return a;
+        }
+    }
+    return RES_REPORT_TYPES;
+}
+
+/**
+ * Writes a table of all resources to a file, including the estimated
+ * memory used by each type of object, load times and the total resident
+ * and peak memory. Resources that still have owners are listed separately;
+ * at shutdown, these are leaks.
+ */
+void debug_res_write(FILE *out) {
+    DATAFILE *data = pack_ref();
+    CGRES *item;
+    long bytes[RES_REPORT_TYPES + 1];
+    long total;
+    int a, b, owned = 0;
+
+    fprintf(out, "Resource list:\n\n");
+    fprintf(
+        out,
+        "slot   handle state    objs own loads hits miss evict    ms    bytes\n"
+    );
+    for (a = 0; a < res_slot_count; ++a) {
+        item = res_slots[a].item;
+        if (!item) {
+            continue;
+        }
+        memset(bytes, 0, sizeof(bytes));
+        total = 0;
+        for (b = 0; b < item->obj_count; ++b) {
+            if (!pack_obj_loaded(item->objs[b])) {
+                continue;
+            }
+            bytes[res_type_index(data[item->objs[b]].type)] +=
+                pack_obj_mem(item->objs[b]);
+            total += pack_obj_mem(item->objs[b]);
+        }
+        fprintf(
+            out,
+            "%03d %8x %-8s %4d %3d %5d %4d %4d %5d %5ld %8ld\n",
+            a,
+            item->id,
+            item->data ? (item->own_count ? "loaded" : "pooled") : "unloaded",
+            item->obj_count,
+            item->own_count,
+            item->loads,
+            item->hits,
+            item->misses,
+            item->evictions,
+            item->load_ms,
+            total
+        );
+        if (total > 0) {
+            fprintf(out, "   ");
+            for (b = 0; b <= RES_REPORT_TYPES; ++b) {
+                if (bytes[b] > 0) {
+                    fprintf(out, " %s=%ld", RES_REPORT_TYPE_NAMES[b], bytes[b]);
+                }
+            }
+            fprintf(out, "\n");
+        }
+        if (item->own_count > 0) {
+            owned += 1;
+        }
+    }
+
+    fprintf(
+        out,
+        "\nresident=%ld peak=%ld pool=%ld/%ld\n"
+        "loads=%d hits=%d misses=%d evictions=%d stale=%d\n",
+        pack_mem_resident(),
+        pack_mem_peak(),
+        pool_size,
+        pool_budget,
+        res_total_loads,
+        res_total_hits,
+        res_total_misses,
+        res_total_evictions,
+        res_total_stale
+    );
+
+    if (res_trans_count > 0) {
+        fprintf(out, "\nHandler transitions (state: ms):\n\n");
+        for (a = 0; a < res_trans_count; ++a) {
+            fprintf(out, "%d: %ld\n", res_trans_states[a], res_trans_ms[a]);
+        }
+    }
+
+    if (owned == 0) {
+        return;
+    }
+    fprintf(out, "\nResources that still have owners:\n\n");
+    for (a = 0; a < res_slot_count; ++a) {
+        item = res_slots[a].item;
+        if (item && item->own_count > 0) {
+            fprintf(out, "%03d: owners={", a);
+            print_owners(out, item);
+            fprintf(out, "}\n");
+        }
+    }
+}
 
 /**
  * Prints out a list of all resources for debugging.
  */
 void debug_res_list() {
-    printf("Resource list:\n\n");
-    for (int a = 0; a < 1000; ++a) {
-        if (res_list[a]) {
-            printf("%03d: ", a);
-            debug_res(res_list[a]);
-        }
+    debug_res_write(stdout);
+}
+
+/**
+ * Writes the resource list to a file for debugging purposes.
+ */
+int write_res_report(char fn[]) {
+    FILE *dbgfile = fopen(fn, "w");
+    if (dbgfile == NULL) {
+        return RES_REPORT_ERROR_OPENING_FILE;
     }
+    debug_res_write(dbgfile);
+    fclose(dbgfile);
+    return RES_REPORT_SUCCESS;
+}
+
+/**
+ * Marks the start of a handler transition. Called when a handler exits.
+ */
+void dep_begin_transition() {
+    res_trans_start = clock();
+}
+
+/**
+ * Marks the end of a handler transition, once the new handler has
+ * loaded its dependencies, initialized itself and drawn its first frame.
+ */
+void dep_end_transition(int state) {
+    if (res_trans_count >= RES_TRANSITIONS_MAX) {
+        return;
+    }
+    res_trans_states[res_trans_count] = state;
+    res_trans_ms[res_trans_count] =
+        ((clock() - res_trans_start) * 1000) / CLOCKS_PER_SEC;
+    res_trans_count += 1;
 }
 
 /**
  * Prints a description of a single resource for debugging.
  */
 void debug_res(CGRES *item) {
-    int a;
-    bool lstart = FALSE;
-
     printf(
-        "<CGRES (%s) id=%d path=\"%s\" own_count=%d owners={",
-        item->data ? "loaded" : "unloaded",
+        "<CGRES (%s) id=%d objs=%d size=%ld loads=%d hits=%d misses=%d "
+        "evictions=%d load_ms=%ld own_count=%d owners={",
+        item->data ? (item->own_count ? "loaded" : "pooled") : "unloaded",
         item->id,
-        item->path,
+        item->obj_count,
+        item->size,
+        item->loads,
+        item->hits,
+        item->misses,
+        item->evictions,
+        item->load_ms,
         item->own_count
     );
-    for (a = 0; a < RES_OWNERS_MAX; ++a) {
-        if (item->owners[a] != -1) {
-            if (lstart) {
-                printf(",");
-            }
-            printf("%i", item->owners[a]);
-            lstart = TRUE;
-        }
-    }
+    print_owners(stdout, item);
     printf("}>\n");
 }
 
 /**
  * Initializes and returns a new CGRES object.
  */
-static CGRES *init_cgres(int id, char *path) {
+static CGRES *init_cgres(int id, int *objs, int obj_count, int (*cb)(),
+    void (*unload_cb)())
+{
     CGRES *item = malloc(sizeof(CGRES));
     item->id = id;
     item->own_count = 0;
+    item->own_bits = item->own_inline;
+    item->own_words = RES_OWNERS_INLINE;
+    memset(item->own_inline, 0, sizeof(item->own_inline));
+    item->loads = 0;
+    item->hits = 0;
+    item->misses = 0;
+    item->evictions = 0;
+    item->size = 0;
+    item->pool_prev = NULL;
+    item->pool_next = NULL;
+    item->loader = NULL;
+    item->load_start = 0;
+    item->load_ms = 0;
     item->data = 0;
-    strcpy(item->path, path);
-    memset(item->owners, 0xFF, RES_OWNERS_MAX * sizeof(int));
+    item->failed = false;
+    item->objs = objs;
+    item->obj_count = obj_count;
+    item->cb = cb;
+    item->unload_cb = unload_cb;
     return item;
 }
 
+/**
+ * Looks up a resource by its handle. Returns NULL if the handle is invalid,
+ * or stale (i.e. the resource it referred to has been unregistered).
+ */
+static CGRES *res_get(int res) {
+    int slot = res & RES_SLOT_MASK;
+    int gen = res >> RES_SLOT_BITS;
+
+    if (res <= 0 || slot >= res_slot_count || res_slots[slot].gen != gen) {
+        res_total_stale += 1;
+        return NULL;
+    }
+    return res_slots[slot].item;
+}
+
+/**
+ * Returns whether req is one of the owners of a resource.
+ */
+static bool owner_test(CGRES *item, int req) {
+    if (req / 32 >= item->own_words) {
+        return false;
+    }
+    return (item->own_bits[req / 32] & (1u << (req % 32))) != 0;
+}
+
+/**
+ * Adds req to the owners of a resource. The owner set starts out inside
+ * the resource itself, and is moved to the heap if a requester ID
+ * doesn't fit.
+ */
+static void owner_set(CGRES *item, int req) {
+    uint32_t *bits;
+    int words;
+
+    if (req / 32 >= item->own_words) {
+        words = (req / 32) + 1;
+        bits = malloc(words * sizeof(uint32_t));
+        memset(bits, 0, words * sizeof(uint32_t));
+        memcpy(bits, item->own_bits, item->own_words * sizeof(uint32_t));
+        if (item->own_bits != item->own_inline) {
+            free(item->own_bits);
+        }
+        item->own_bits = bits;
+        item->own_words = words;
+    }
+    item->own_bits[req / 32] |= 1u << (req % 32);
+}
+
+/**
+ * Removes req from the owners of a resource.
+ */
+static void owner_clear(CGRES *item, int req) {
+    item->own_bits[req / 32] &= ~(1u << (req % 32));
+}
+
+/**
+ * Returns the approximate number of bytes of memory used by a loaded
+ * resource. This is the sum of the memory used by all of its objects,
+ * which can be a lot more than their size in the pack.
+ */
+static long res_size(CGRES *item) {
+    long size = 0;
+    int a;
+
+    for (a = 0; a < item->obj_count; ++a) {
+        size += pack_obj_mem(item->objs[a]);
+    }
+    return size;
+}
+
+/**
+ * Loads all objects of a resource from the pack. Returns false if any
+ * of them couldn't be loaded, in which case nothing stays loaded.
+ */
+static bool res_load(CGRES *item) {
+    int a;
+
+    for (a = 0; a < item->obj_count; ++a) {
+        if (!pack_load_obj(item->objs[a])) {
+            while (--a >= 0) {
+                pack_unload_obj(item->objs[a]);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Unloads all objects of a resource, after letting the resource free
+ * anything that refers to them.
+ */
+static void res_unload(CGRES *item) {
+    int a;
+
+    if (item->data != NULL && item->unload_cb != 0) {
+        item->unload_cb();
+    }
+    for (a = 0; a < item->obj_count; ++a) {
+        pack_unload_obj(item->objs[a]);
+    }
+    item->data = NULL;
+}
+
+/**
+ * Removes a resource from the resident pool without unloading it.
+ */
+static void pool_remove(CGRES *item) {
+    if (item->pool_prev) {
+        item->pool_prev->pool_next = item->pool_next;
+    }
+    else {
+        pool_head = item->pool_next;
+    }
+    if (item->pool_next) {
+        item->pool_next->pool_prev = item->pool_prev;
+    }
+    else {
+        pool_tail = item->pool_prev;
+    }
+    item->pool_prev = NULL;
+    item->pool_next = NULL;
+    pool_size -= item->size;
+}
+
+/**
+ * Evicts the least recently released resources from the pool until
+ * the pool fits inside its byte budget.
+ */
+static void pool_trim() {
+    CGRES *item;
+
+    while (pool_tail && pool_size > pool_budget) {
+        item = pool_tail;
+        pool_remove(item);
+        res_unload(item);
+        item->evictions += 1;
+        res_total_evictions += 1;
+    }
+}
+
+/**
+ * Adds a resource that no longer has any owners to the resident pool,
+ * evicting older resources if we're over budget.
+ */
+static void pool_add(CGRES *item) {
+    item->pool_prev = NULL;
+    item->pool_next = pool_head;
+    if (pool_head) {
+        pool_head->pool_prev = item;
+    }
+    else {
+        pool_tail = item;
+    }
+    pool_head = item;
+    pool_size += item->size;
+    pool_trim();
+}
+
+/**
+ * Sets the maximum number of bytes that released resources can take up
+ * while being kept resident. Setting this to 0 means resources are
+ * unloaded as soon as their last owner is gone.
+ */
+void dep_set_pool_budget(long bytes) {
+    pool_budget = bytes;
+    pool_trim();
+}
+
+/**
+ * Unloads all resources in the resident pool.
+ */
+void dep_flush_pool() {
+    long budget = pool_budget;
+    dep_set_pool_budget(0);
+    pool_budget = budget;
+}
+
+/**
+ * Marks a resource as loaded and calls its callback function.
+ * If the callback can't use the objects, the resource is unloaded again
+ * and stays unavailable, like when one of its objects can't be read.
+ */
+static void res_loaded(CGRES *item, bool success) {
+    item->failed = !success;
+    if (!success) {
+        return;
+    }
+    item->data = pack_ref();
+    if (item->cb != 0 && item->cb() != 0) {
+        res_unload(item);
+        item->failed = true;
+        return;
+    }
+    item->size = res_size(item);
+    item->load_ms = ((clock() - item->load_start) * 1000) / CLOCKS_PER_SEC;
+    item->loads += 1;
+    res_total_loads += 1;
+}
+
+/**
+ * Blocks until a resource that's being loaded incrementally is done.
+ */
+static void res_finish_loading(CGRES *item) {
+    CGLOADER *loader = item->loader;
+
+    if (!loader) {
+        return;
+    }
+    item->loader = NULL;
+    res_loading -= 1;
+    res_loaded(item, loader_finish(loader));
+}
+
 /**
  * Returns a reference to a loaded datafile. Used to access the data
  * previously loaded by dependency management.
+ *
+ * All resources share the same datafile: the resource pack. Objects are
+ * accessed by their index in the pack, e.g. dep_data_ref(res)[FLIM_WHITE].
+ *
+ * If the resource is still being loaded incrementally, this waits for it.
+ * Use dep_ready() first to avoid blocking.
  */
 DATAFILE *dep_data_ref(int res) {
-    return res_list[res]->data;
+    CGRES *item = res_get(res);
+    if (!item) {
+        return NULL;
+    }
+    res_finish_loading(item);
+    return item->data;
+}
+
+/**
+ * Returns whether a resource has been fully loaded.
+ */
+bool dep_ready(int res) {
+    CGRES *item = res_get(res);
+    return item && item->data != NULL;
+}
+
+/**
+ * Returns whether the last attempt to load a resource failed, e.g.
+ * because an object couldn't be read or its callback couldn't use it.
+ * While a resource is still being loaded incrementally, this is false.
+ */
+bool dep_failed(int res) {
+    CGRES *item = res_get(res);
+    return item && item->failed;
+}
+
+/**
+ * Returns the combined progress of all incremental loads as a percentage.
+ * Returns 100 if nothing is being loaded.
+ */
+int dep_progress() {
+    int a, n = 0, progress = 0;
+    CGRES *item;
+
+    if (res_loading == 0) {
+        return 100;
+    }
+    for (a = 0; a < res_slot_count; ++a) {
+        item = res_slots[a].item;
+        if (item && item->loader) {
+            progress += loader_progress(item->loader);
+            n += 1;
+        }
+    }
+    return progress / n;
+}
+
+/**
+ * Advances all incremental loads by a bounded amount of work.
+ * Called once per frame by the game loop.
+ */
+void dep_update() {
+    int a;
+    CGRES *item;
+
+    if (res_loading == 0) {
+        return;
+    }
+    for (a = 0; a < res_slot_count; ++a) {
+        item = res_slots[a].item;
+        if (item && item->loader && loader_step(item->loader)) {
+            res_finish_loading(item);
+        }
+    }
+}
+
+/**
+ * Registers req as an owner of a resource.
+ * Returns false if it already was one.
+ *
+ * If count is set, the request is counted as a hit if the resource is
+ * already in memory, and as a miss otherwise. Preloading isn't counted.
+ */
+static bool res_add_owner(CGRES *item, int req, bool count) {
+    // Check if this req is already registered as requiring this resource.
+    if (owner_test(item, req)) {
+        return false;
+    }
+    owner_set(item, req);
+    item->own_count += 1;
+
+    // If someone else already loaded the resource, we can reuse it.
+    if (item->data != NULL) {
+        if (item->own_count == 1) {
+            pool_remove(item);
+        }
+        if (count) {
+            item->hits += 1;
+            res_total_hits += 1;
+        }
+    }
+    else if (count) {
+        item->misses += 1;
+        res_total_misses += 1;
+    }
+    return true;
 }
 
 /**
@@ -96,29 +640,61 @@ DATAFILE *dep_data_ref(int res) {
  * to avoid accidentally using the wrong string, which would cause
  * a memory leak.
  *
+ * Resources are reference counted: the datafile is only loaded when the
+ * first owner registers. Any owner after that gets the already loaded data.
+ * If the resource was released earlier but is still in the resident pool,
+ * it's taken out of the pool instead of being loaded from disk again.
+ *
  * In most cases, this is used in low level objects, such as a sprite struct.
  */
 void dep_require(int res, int req) {
-    int a;
-    int *own_count = &res_list[res]->own_count;
+    CGRES *item = res_get(res);
 
-    // Check if this req is already registered as requiring this resource.
-    for (a = 0; a < *own_count; ++a) {
-        if (res_list[res]->owners[a] == req) {
-            // No need to do anything.
-            return;
-        }
+    if (!item || !res_add_owner(item, req, true)) {
+        // No need to do anything.
+        return;
     }
 
-    // The owners array always has a free spot at $own_count.
-    res_list[res]->owners[*own_count] = req;
-    *own_count += 1;
+    // If the resource is being loaded incrementally, finish it now.
+    if (item->loader) {
+        res_finish_loading(item);
+        return;
+    }
 
     // Load the resource file and call its callback function.
-    res_list[res]->data = load_datafile(res_list[res]->path);
-    if (*res_cb[res] != 0) {
-        (*res_cb[res])();
+    if (item->data == NULL) {
+        item->load_start = clock();
+        res_loaded(item, res_load(item));
+    }
+}
+
+/**
+ * Same as dep_require(), but doesn't block until the resource is loaded.
+ *
+ * The resource is loaded incrementally by dep_update() instead, which is
+ * called once per frame. Use dep_ready() or dep_progress() to check
+ * whether it's done; this allows a handler to keep rendering
+ * (e.g. a loading screen) while its dependencies come in.
+ */
+void dep_require_async(int res, int req) {
+    CGRES *item = res_get(res);
+
+    if (!item || !res_add_owner(item, req, true)) {
+        return;
+    }
+    if (item->data != NULL || item->loader != NULL) {
+        return;
+    }
+
+    item->load_start = clock();
+    item->failed = false;
+    item->loader = loader_start(item->objs, item->obj_count);
+    if (!item->loader) {
+        // Without a loader, the resource is loaded in one go instead.
+        res_loaded(item, res_load(item));
+        return;
     }
+    res_loading += 1;
 }
 
 /**
@@ -126,45 +702,435 @@ void dep_require(int res, int req) {
  *
  * This does not necessarily unload the resource. It simply indicates
  * that a particular piece of code no longer needs the resource.
- * If nobody needs a resource anymore, the resource is unloaded.
+ * If nobody needs a resource anymore, it's moved to the resident pool,
+ * from which it's only unloaded when the pool runs out of space.
  */
 void dep_forget(int res, int req) {
+    CGRES *item = res_get(res);
+
+    if (!item || !owner_test(item, req)) {
+        return;
+    }
+    owner_clear(item, req);
+    item->own_count -= 1;
+    if (item->own_count > 0) {
+        return;
+    }
+
+    // If nobody needs the resource anymore while it's still being
+    // loaded incrementally, stop loading it.
+    if (item->loader != NULL) {
+        loader_abort(item->loader);
+        item->loader = NULL;
+        res_loading -= 1;
+    }
+
+    // Release the datafile to the pool once the last owner is gone.
+    if (item->data != NULL) {
+        pool_add(item);
+    }
+}
+
+/**
+ * Unloads a resource right away if nobody owns it, instead of keeping it
+ * in the resident pool. Useful for things that are only ever shown once,
+ * such as the logos at the start of the game.
+ */
+void dep_discard(int res) {
+    CGRES *item = res_get(res);
+
+    if (!item || item->own_count > 0 || item->data == NULL) {
+        return;
+    }
+    pool_remove(item);
+    res_unload(item);
+}
+
+/**
+ * Returns the resource for a single object in the pack.
+ * These resources are registered on first use.
+ * Returns RES_NONE if there's no such object, or not enough memory.
+ */
+static int obj_res_id(int obj) {
+    int a;
+
+    if (obj < 0 || obj >= pack_count()) {
+        return RES_NONE;
+    }
+    if (obj_res == NULL) {
+        obj_res = malloc(pack_count() * sizeof(int));
+        obj_ids = malloc(pack_count() * sizeof(int));
+        if (!obj_res || !obj_ids) {
+            free(obj_res);
+            free(obj_ids);
+            obj_res = NULL;
+            obj_ids = NULL;
+            return RES_NONE;
+        }
+        for (a = 0; a < pack_count(); ++a) {
+            obj_res[a] = RES_NONE;
+            obj_ids[a] = a;
+        }
+    }
+    if (obj_res[obj] == RES_NONE) {
+        obj_res[obj] = res_register(&obj_ids[obj], 1, 0, 0);
+    }
+    return obj_res[obj];
+}
+
+/**
+ * Loads a single object from the pack for a specific piece of code.
+ *
+ * This works just like dep_require(), but for one object rather than
+ * a whole resource. For example, a handler that shows one image at a time
+ * can require just that image and its palette. Each object is reference
+ * counted separately, and objects are shared with any resource that
+ * contains them, so they're never loaded twice.
+ */
+void dep_require_obj(int obj, int req) {
+    dep_require(obj_res_id(obj), req);
+}
+
+/**
+ * Same as dep_require_obj(), but doesn't block until the object is loaded.
+ * See dep_require_async() for more information.
+ */
+void dep_require_obj_async(int obj, int req) {
+    dep_require_async(obj_res_id(obj), req);
+}
+
+/**
+ * Returns whether a single object has been fully loaded.
+ */
+bool dep_ready_obj(int obj) {
+    return dep_ready(obj_res_id(obj));
+}
+
+/**
+ * Returns whether a single object failed to load.
+ * See dep_failed() for more information.
+ */
+bool dep_failed_obj(int obj) {
+    return dep_failed(obj_res_id(obj));
+}
+
+/**
+ * Indicates that a single object is no longer needed.
+ * See dep_forget() for more information.
+ */
+void dep_forget_obj(int obj, int req) {
+    dep_forget(obj_res_id(obj), req);
+}
+
+/**
+ * Unloads a single object right away if nobody owns it.
+ * See dep_discard() for more information.
+ */
+void dep_discard_obj(int obj) {
+    dep_discard(obj_res_id(obj));
+}
+
+/**
+ * Sorts a list of pack objects by their offset in the pack.
+ */
+static void sort_objs(int *objs, int count) {
+    int a, b, obj;
+    long ofs;
+
+    for (a = 1; a < count; ++a) {
+        obj = objs[a];
+        ofs = pack_obj_offset(obj);
+        for (b = a; b > 0 && pack_obj_offset(objs[b - 1]) > ofs; --b) {
+            objs[b] = objs[b - 1];
+        }
+        objs[b] = obj;
+    }
+}
+
+/**
+ * Returns the number of resources and objects in a manifest.
+ */
+static int manifest_size(DEP_MANIFEST *manifest) {
+    int a, n = 0;
+
+    for (a = 0; manifest->res && manifest->res[a] != NULL; ++a) {
+        n += 1;
+    }
+    for (a = 0; manifest->objs && manifest->objs[a] != DEP_END; ++a) {
+        n += 1;
+    }
+    return n;
+}
+
+/**
+ * Returns the resources listed in a manifest. Single objects are returned
+ * as the resources that are automatically registered for them.
+ * Returns the number of resources written to items.
+ */
+static int manifest_items(DEP_MANIFEST *manifest, CGRES **items) {
+    CGRES *item;
     int a, n = 0;
-    int own_sz = RES_OWNERS_MAX * sizeof(int);
-    int owners[RES_OWNERS_MAX];
-    int *own_count = &res_list[res]->own_count;
 
-    // Unload the datafile. If anyone is still using it
-    // after this, the game will crash.
-    unload_datafile(res_list[res]->data);
-    res_list[res]->data = NULL;
+    for (a = 0; manifest->res && manifest->res[a] != NULL; ++a) {
+        if ((item = res_get(*manifest->res[a])) != NULL) {
+            items[n++] = item;
+        }
+    }
+    for (a = 0; manifest->objs && manifest->objs[a] != DEP_END; ++a) {
+        if ((item = res_get(obj_res_id(manifest->objs[a]))) != NULL) {
+            items[n++] = item;
+        }
+    }
+    return n;
+}
+
+/**
+ * Loads a number of resources in one batch.
+ *
+ * The objects of all resources that aren't loaded yet are combined,
+ * duplicates are removed and the rest is read in on-disk order, so that
+ * the pack is read front to back only once. After that, the resources
+ * themselves are marked as loaded, which doesn't need any more I/O.
+ */
+static void res_load_batch(CGRES **items, int count) {
+    clock_t start = clock();
+    int *objs;
+    bool *ok;
+    int a, b, n = 0, total = 0;
+
+    for (a = 0; a < count; ++a) {
+        // A resource that's being loaded incrementally is finished first.
+        res_finish_loading(items[a]);
+        if (items[a]->data == NULL) {
+            total += items[a]->obj_count;
+        }
+    }
+    if (total == 0) {
+        return;
+    }
+
+    objs = malloc(total * sizeof(int));
+    ok = malloc(total * sizeof(bool));
+    if (!objs || !ok) {
+        // Load the resources one by one instead.
+        free(objs);
+        free(ok);
+        for (a = 0; a < count; ++a) {
+            if (items[a]->data == NULL) {
+                items[a]->load_start = start;
+                res_loaded(items[a], res_load(items[a]));
+            }
+        }
+        return;
+    }
+    for (a = 0; a < count; ++a) {
+        if (items[a]->data != NULL) {
+            continue;
+        }
+        for (b = 0; b < items[a]->obj_count; ++b) {
+            objs[n++] = items[a]->objs[b];
+        }
+    }
+
+    // Sort by offset and skip duplicates, which are now next to each other.
+    sort_objs(objs, n);
+    for (a = 0, b = 0; a < n; ++a) {
+        if (b == 0 || objs[b - 1] != objs[a]) {
+            objs[b++] = objs[a];
+        }
+    }
+    n = b;
+    for (a = 0; a < n; ++a) {
+        ok[a] = pack_load_obj(objs[a]);
+    }
+
+    // Every object is loaded now; the resources add their own references.
+    for (a = 0; a < count; ++a) {
+        if (items[a]->data == NULL) {
+            items[a]->load_start = start;
+            res_loaded(items[a], res_load(items[a]));
+        }
+    }
+    for (a = 0; a < n; ++a) {
+        if (ok[a]) {
+            pack_unload_obj(objs[a]);
+        }
+    }
+    free(objs);
+    free(ok);
+}
+
+/**
+ * Loads all dependencies in a manifest for a specific piece of code.
+ *
+ * This is the same as calling dep_require() and dep_require_obj() for
+ * every item in the manifest, except that everything that isn't loaded
+ * yet is loaded in a single batch, in the order it's stored on disk.
+ * Handlers declare their dependencies this way, e.g.:
+ *
+ *     int *LOGOS_RES[] = { &RES_ID_TIN, &RES_ID_FLIM, NULL };
+ *     int LOGOS_OBJS[] = { ASLOGO_IMG, ASLOGO_PALETTE, DEP_END };
+ *     DEP_MANIFEST LOGOS_DEPS = { LOGOS_RES, LOGOS_OBJS };
+ */
+void dep_require_manifest(DEP_MANIFEST *manifest, int req) {
+    int a, n, count = 0, size = manifest_size(manifest);
+    CGRES **items;
+
+    if (size == 0) {
+        return;
+    }
+    items = malloc(size * sizeof(CGRES *));
+    if (!items) {
+        // Require everything one by one instead of in one batch.
+        for (a = 0; manifest->res && manifest->res[a] != NULL; ++a) {
+            dep_require(*manifest->res[a], req);
+        }
+        for (a = 0; manifest->objs && manifest->objs[a] != DEP_END; ++a) {
+            dep_require_obj(manifest->objs[a], req);
+        }
+        return;
+    }
+    n = manifest_items(manifest, items);
+    for (a = 0; a < n; ++a) {
+        // Only resources that weren't already owned by req need loading.
+        if (res_add_owner(items[a], req, true)) {
+            items[count++] = items[a];
+        }
+    }
+    res_load_batch(items, count);
+    free(items);
+}
 
-    // Remove the requester from the list of resource owners.
-    // We'll do this by rebuilding the array so that there are no gaps.
-    memset(owners, 0xFF, own_sz);
+/**
+ * Indicates that the dependencies in a manifest are no longer needed.
+ * See dep_forget() for more information.
+ */
+void dep_forget_manifest(DEP_MANIFEST *manifest, int req) {
+    int a;
+
+    for (a = 0; manifest->res && manifest->res[a] != NULL; ++a) {
+        dep_forget(*manifest->res[a], req);
+    }
+    for (a = 0; manifest->objs && manifest->objs[a] != DEP_END; ++a) {
+        dep_forget_obj(manifest->objs[a], req);
+    }
+}
 
-    // Copy all except req from the original list.
-    for (a = 0; a < *own_count; ++a) {
-        if (res_list[res]->owners[a] != req) {
-            owners[n] = res_list[res]->owners[a];
-            n+= 1;
+/**
+ * Warms up the resident pool with the dependencies of several manifests,
+ * e.g. those of the first few game states. Everything is loaded in one
+ * batch, then released to the pool; it stays resident as long as
+ * the pool's budget allows, so the handlers don't have to wait for it.
+ */
+void dep_warm(DEP_MANIFEST **manifests, int count) {
+    CGRES **items;
+    int req = req_id();
+    int a, b, n = 0, size = 0;
+
+    for (a = 0; a < count; ++a) {
+        size += manifest_size(manifests[a]);
+    }
+    // Warming up is only an optimization, so skip it if there's no memory.
+    items = size > 0 ? malloc(size * sizeof(CGRES *)) : NULL;
+    if (!items) {
+        return;
+    }
+    for (a = 0; a < count; ++a) {
+        n += manifest_items(manifests[a], items + n);
+    }
+
+    // Resources can appear in more than one manifest.
+    for (a = 0, size = 0; a < n; ++a) {
+        for (b = 0; b < size; ++b) {
+            if (items[b] == items[a]) {
+                break;
+            }
+        }
+        if (b == size) {
+            items[size++] = items[a];
+        }
+    }
+    n = size;
+
+    // Keep everything owned while loading, so nothing is evicted
+    // from the pool before the batch is done.
+    for (a = 0; a < n; ++a) {
+        res_add_owner(items[a], req, false);
+    }
+    res_load_batch(items, n);
+    for (a = 0; a < n; ++a) {
+        dep_forget(items[a]->id, req);
+    }
+    free(items);
+}
+
+/**
+ * Returns a free slot in the resource table, growing it if necessary.
+ */
+static int res_alloc_slot() {
+    int a, slot, size;
+
+    if (res_free_slot == -1) {
+        size = res_slot_count ? res_slot_count * 2 : RES_SLOTS_INITIAL;
+        res_slots = realloc(res_slots, size * sizeof(RES_SLOT));
+        for (a = res_slot_count; a < size; ++a) {
+            res_slots[a].item = NULL;
+            res_slots[a].gen = 1;
+            res_slots[a].next_free = a + 1 < size ? a + 1 : -1;
         }
+        res_free_slot = res_slot_count;
+        res_slot_count = size;
     }
+    slot = res_free_slot;
+    res_free_slot = res_slots[slot].next_free;
+    return slot;
+}
 
-    // Copy the new list to the resource and update its owners count.
-    memcpy(res_list[res]->owners, owners, own_sz);
-    *own_count = n;
+/**
+ * Registers a resource and returns its handle. After it has been registered,
+ * it can be requested by anything. All resources are registered all at once
+ * during program startup. See <register.c> for more information.
+ *
+ * A resource is a list of objects in the resource pack. They're sorted
+ * in on-disk order, so that loading a resource only ever seeks forward.
+ * cb is called every time the resource has been loaded, and unload_cb
+ * every time it's about to be unloaded; either may be 0.
+ *
+ * The handle contains the resource's slot in the resource table, and
+ * a generation number that changes whenever the slot is reused. That way,
+ * a handle to an unregistered resource is recognized rather than
+ * referring to whatever takes its place.
+ */
+int res_register(int objs[], int obj_count, int (*cb)(),
+    void (*unload_cb)())
+{
+    int slot = res_alloc_slot();
+    int res = (res_slots[slot].gen << RES_SLOT_BITS) | slot;
+
+    sort_objs(objs, obj_count);
+    res_slots[slot].item = init_cgres(res, objs, obj_count, cb, unload_cb);
+    return res;
 }
 
 /**
- * Registers a resource. After it has been registered, it can be requested
- * by anything. All resources are registered all at once during
- * program startup. See <init.c> for more information.
+ * Unregisters a resource, unloading it if necessary. Any handles to it
+ * become stale. Resources that still have owners can't be unregistered.
  */
-void res_register(int res, char path[], void (*cb)()) {
-    CGRES *resource = init_cgres(res, path);
-    res_list[res] = resource;
+void res_unregister(int res) {
+    CGRES *item = res_get(res);
+    int slot = res & RES_SLOT_MASK;
+
+    if (!item || item->own_count > 0) {
+        return;
+    }
+    dep_discard(res);
+    if (item->own_bits != item->own_inline) {
+        free(item->own_bits);
+    }
+    free(item);
 
-    // Store our callback function if we have one.
-    res_cb[res] = cb;
+    res_slots[slot].item = NULL;
+    res_slots[slot].gen = (res_slots[slot].gen % RES_GEN_MAX) + 1;
+    res_slots[slot].next_free = res_free_slot;
+    res_free_slot = slot;
 }
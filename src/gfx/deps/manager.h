@@ -4,32 +4,130 @@
  */
 
 #include <allegro.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
 
 #ifndef __CEEGEE_GFX_DEPS_MANAGER__
 #define __CEEGEE_GFX_DEPS_MANAGER__
 
-// Maximum number of objects that can claim to own a resource.
-#define RES_OWNERS_MAX 100
-// Maximum size of a resource path.
-#define RES_PATH_MAX 50
+#include "src/gfx/deps/loader.h"
+
+// Number of 32-bit words of owner bits stored inside a resource.
+// Requester IDs above this use a larger set on the heap.
+#define RES_OWNERS_INLINE 2
+// Resource handles contain a slot number in the lower bits,
+// and the slot's generation in the upper bits.
+#define RES_SLOT_BITS 16
+#define RES_SLOT_MASK ((1 << RES_SLOT_BITS) - 1)
+#define RES_GEN_MAX 0x7FFF
+// Initial number of slots in the resource table.
+#define RES_SLOTS_INITIAL 32
+// Never a valid resource handle.
+#define RES_NONE 0
+// Terminates the object list of a dependency manifest.
+#define DEP_END -1
+// Default number of bytes that unused resources may keep resident.
+#define RES_POOL_BUDGET 262144
+// Number of object types with their own column in the resource report.
+#define RES_REPORT_TYPES 5
+// Number of handler transitions whose timing is kept for the report.
+#define RES_TRANSITIONS_MAX 32
+#define RES_REPORT_ERROR_OPENING_FILE 1
+#define RES_REPORT_SUCCESS 0
 
 // CGRES (CeeGee resource) object.
+// The owners are stored as a bitset indexed by requester ID.
+// loads counts how often the datafile was loaded. hits and misses count
+// how often a dep_require() call could reuse the already loaded data,
+// and how often it couldn't; preloading with dep_warm() isn't counted.
+// Resources without owners are kept in the resident pool, which is
+// a linked list using pool_prev and pool_next.
+// While a resource is being loaded incrementally, loader is set.
+// load_ms is how long the last load took, from request to completion.
+// objs is the list of objects in the resource pack that make up the resource.
+// failed is set if the last attempt to load the resource didn't succeed.
+// cb is called once the objects are loaded, and returns nonzero if
+// the resource can't be used; it's then unloaded again. unload_cb is called
+// right before the objects are unloaded, to free anything cb made from them.
 typedef struct CGRES {
     int id;
     int own_count;
-    int owners[RES_OWNERS_MAX];
-    char path[RES_PATH_MAX];
-    int p_extra;
+    int own_words;
+    uint32_t *own_bits;
+    uint32_t own_inline[RES_OWNERS_INLINE];
+    int loads;
+    int hits;
+    int misses;
+    int evictions;
+    long size;
+    clock_t load_start;
+    long load_ms;
+    int *objs;
+    int obj_count;
     DATAFILE *data;
+    bool failed;
+    int (*cb)();
+    void (*unload_cb)();
+    CGLOADER *loader;
+    struct CGRES *pool_prev, *pool_next;
 } CGRES;
 
+// Static list of everything a handler depends on. res is a NULL terminated
+// list of pointers to resource handles (since those are only known after
+// registration), and objs is a DEP_END terminated list of single objects
+// in the pack. Either can be NULL.
+typedef struct DEP_MANIFEST {
+    int **res;
+    int *objs;
+} DEP_MANIFEST;
+
+// Slot in the resource table. gen is incremented whenever
+// the slot is freed, to invalidate old handles.
+typedef struct RES_SLOT {
+    CGRES *item;
+    int gen;
+    int next_free;
+} RES_SLOT;
+
 
 DATAFILE *dep_data_ref(int res);
-static CGRES *init_cgres(int id, char *path);
+bool dep_failed(int res);
+bool dep_failed_obj(int obj);
+bool dep_ready(int res);
+bool dep_ready_obj(int obj);
+int dep_progress();
+static CGRES *init_cgres(int id, int *objs, int obj_count, int (*cb)(),
+    void (*unload_cb)());
+static int manifest_items(DEP_MANIFEST *manifest, CGRES **items);
+static int manifest_size(DEP_MANIFEST *manifest);
+static int obj_res_id(int obj);
+static void res_load_batch(CGRES **items, int count);
+static int res_type_index(int type);
+static void print_owners(FILE *out, CGRES *item);
+int write_res_report(char fn[]);
 void debug_res_list();
 void debug_res(CGRES *item);
+void debug_res_write(FILE *out);
+void dep_begin_transition();
+void dep_discard(int res);
+void dep_end_transition(int state);
+void dep_discard_obj(int obj);
+void dep_flush_pool();
+void dep_set_pool_budget(long bytes);
 void dep_forget(int res, int req);
+void dep_forget_manifest(DEP_MANIFEST *manifest, int req);
+void dep_forget_obj(int obj, int req);
 void dep_require(int res, int req);
-void res_register(int res, char path[], void (*cb)());
+void dep_require_async(int res, int req);
+void dep_require_manifest(DEP_MANIFEST *manifest, int req);
+void dep_require_obj(int obj, int req);
+void dep_require_obj_async(int obj, int req);
+void dep_update();
+void dep_warm(DEP_MANIFEST **manifests, int count);
+int res_register(int objs[], int obj_count, int (*cb)(),
+    void (*unload_cb)());
+void res_unregister(int res);
 
 #endif
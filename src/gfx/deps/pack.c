@@ -0,0 +1,628 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "src/gfx/deps/atlas.h"
+#include "src/gfx/deps/lzbmp.h"
+#include "src/gfx/deps/pack.h"
+#include "src/gfx/glyphs.h"
+
+// All game resources are stored as objects in this single datafile.
+char PACK_PATH[] = "data\\res\\ceegee.dat";
+
+// Index of the pack; contains the offset of every object in the file.
+DATAFILE_INDEX *pack_index = NULL;
+// The objects in the pack. Objects that aren't loaded have a NULL dat.
+// Terminated by a DAT_END object, like a regular datafile.
+DATAFILE *pack_data = NULL;
+// The objects as returned by Allegro, needed to unload them again.
+DATAFILE **pack_objs = NULL;
+// Number of times each object has been loaded. Objects can be shared by
+// several resources, so they're only unloaded when this drops to zero.
+int *pack_refs = NULL;
+// Number of objects in the pack.
+int pack_size = 0;
+// Estimated number of bytes of memory used by each loaded object.
+long *pack_mem = NULL;
+// Estimated number of bytes used by all loaded objects, and the most
+// that was ever in use at the same time.
+long pack_resident = 0;
+long pack_peak = 0;
+
+// The pack stays open while the game runs, so that objects can be read
+// without opening it again. pack_file_pos is the current position in it,
+// counted the same way as the offsets in the index.
+PACKFILE *pack_file = NULL;
+long pack_file_pos = 0;
+
+// Object types that can be read in parts, and the functions that make
+// objects out of their data. See pack_register_type().
+int pack_types[PACK_TYPES_MAX];
+PACK_LOAD_FN pack_loaders[PACK_TYPES_MAX];
+int pack_type_count = 0;
+
+// Lets the load functions read an object's data from memory.
+PACKFILE_VTABLE pack_memfile_vtable = {
+    memfile_fclose,
+    memfile_getc,
+    memfile_ungetc,
+    memfile_fread,
+    memfile_putc,
+    memfile_fwrite,
+    memfile_fseek,
+    memfile_feof,
+    memfile_ferror
+};
+
+/**
+ * Reads a number of bytes from the pack at the current position.
+ * Returns false if they couldn't all be read, in which case the pack
+ * is closed, to be opened again by the next seek.
+ */
+static bool pack_read(void *buf, long n) {
+    if (pack_fread(buf, n, pack_file) != n) {
+        pack_fclose(pack_file);
+        pack_file = NULL;
+        return false;
+    }
+    pack_file_pos += n;
+    return true;
+}
+
+/**
+ * Reads a big-endian 32-bit number from the pack, like pack_mgetl().
+ */
+static bool pack_read_mgetl(long *l) {
+    unsigned char b[4];
+
+    if (!pack_read(b, 4)) {
+        return false;
+    }
+    *l = (long)(int)(
+        ((unsigned)b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3]
+    );
+    return true;
+}
+
+/**
+ * Moves to a position in the pack. Packfiles can only seek forward,
+ * so going back means opening the pack again; since objects are mostly
+ * loaded in on-disk order, this doesn't happen often.
+ * Returns false if the pack can't be read.
+ */
+static bool pack_seek(long offset) {
+    if (pack_file && offset < pack_file_pos) {
+        pack_fclose(pack_file);
+        pack_file = NULL;
+    }
+    if (!pack_file) {
+        pack_file = pack_fopen(pack_index->filename, F_READ_PACKED);
+        pack_file_pos = PACK_MAGIC_SIZE;
+        if (!pack_file) {
+            return false;
+        }
+    }
+    if (offset > pack_file_pos &&
+        pack_fseek(pack_file, offset - pack_file_pos) != 0) {
+        pack_fclose(pack_file);
+        pack_file = NULL;
+        return false;
+    }
+    pack_file_pos = offset;
+    return true;
+}
+
+/**
+ * Opens the resource pack and reads its index. Nothing is loaded yet.
+ * Returns 0 on success, or 1 if the pack can't be read.
+ */
+int pack_open(char *path) {
+    long magic, count;
+    int a;
+
+    // The number of objects is in the datafile header. The pack is
+    // kept open from here on.
+    pack_file = pack_fopen(path, F_READ_PACKED);
+    if (!pack_file) {
+        return 1;
+    }
+    pack_file_pos = PACK_MAGIC_SIZE;
+    if (!pack_read_mgetl(&magic) || magic != DAT_MAGIC ||
+        !pack_read_mgetl(&count) || count <= 0) {
+        if (pack_file) {
+            pack_fclose(pack_file);
+            pack_file = NULL;
+        }
+        return 1;
+    }
+    pack_size = count;
+
+    pack_index = create_datafile_index(path);
+    if (!pack_index) {
+        pack_fclose(pack_file);
+        pack_file = NULL;
+        return 1;
+    }
+
+    pack_data = malloc((pack_size + 1) * sizeof(DATAFILE));
+    pack_objs = malloc(pack_size * sizeof(DATAFILE *));
+    pack_refs = malloc(pack_size * sizeof(int));
+    pack_mem = malloc(pack_size * sizeof(long));
+    for (a = 0; a < pack_size; ++a) {
+        pack_refs[a] = 0;
+        pack_mem[a] = 0;
+        pack_data[a].dat = NULL;
+        pack_data[a].type = 0;
+        pack_data[a].size = 0;
+        pack_data[a].prop = NULL;
+        pack_objs[a] = NULL;
+    }
+    pack_data[pack_size].dat = NULL;
+    pack_data[pack_size].type = DAT_END;
+    pack_data[pack_size].size = 0;
+    pack_data[pack_size].prop = NULL;
+
+    return 0;
+}
+
+/**
+ * Unloads an object, regardless of how many times it was loaded.
+ */
+static void pack_destroy_obj(int obj) {
+    if (!pack_objs[obj]) {
+        return;
+    }
+    unload_datafile_object(pack_objs[obj]);
+    pack_objs[obj] = NULL;
+    pack_refs[obj] = 0;
+    pack_resident -= pack_mem[obj];
+    pack_mem[obj] = 0;
+    pack_data[obj].dat = NULL;
+    pack_data[obj].type = 0;
+    pack_data[obj].size = 0;
+    pack_data[obj].prop = NULL;
+}
+
+/**
+ * Unloads all objects and closes the pack.
+ */
+void pack_close() {
+    int a;
+
+    if (!pack_index) {
+        return;
+    }
+    for (a = 0; a < pack_size; ++a) {
+        pack_destroy_obj(a);
+    }
+    destroy_datafile_index(pack_index);
+    if (pack_file) {
+        pack_fclose(pack_file);
+        pack_file = NULL;
+    }
+    free(pack_data);
+    free(pack_objs);
+    free(pack_refs);
+    free(pack_mem);
+    pack_index = NULL;
+    pack_data = NULL;
+    pack_objs = NULL;
+    pack_refs = NULL;
+    pack_mem = NULL;
+    pack_size = 0;
+}
+
+/**
+ * Returns the pack's object list. The generated pack_data.h header
+ * contains the index of each object, e.g. pack_ref()[FLIM_WHITE].dat.
+ * Only objects that have been loaded have their dat set.
+ */
+DATAFILE *pack_ref() {
+    return pack_data;
+}
+
+/**
+ * Returns the number of objects in the pack.
+ */
+int pack_count() {
+    return pack_size;
+}
+
+/**
+ * Returns the file offset of an object. Objects are stored in
+ * order of increasing offset, so this equals the on-disk order.
+ */
+long pack_obj_offset(int obj) {
+    return pack_index->offset[obj];
+}
+
+/**
+ * Returns whether an object is loaded.
+ */
+bool pack_obj_loaded(int obj) {
+    return pack_objs[obj] != NULL;
+}
+
+/**
+ * Returns the estimated number of bytes of memory used by an object.
+ * This is more accurate than the object's size in the datafile, since
+ * e.g. compiled sprites are much larger in memory than on disk.
+ */
+static long obj_mem_size(DATAFILE *item) {
+    BITMAP *bmp;
+    RLE_SPRITE *rle;
+    COMPILED_SPRITE *cspr;
+    long size;
+    int a;
+
+    switch (item->type) {
+        case DAT_BITMAP:
+        case DAT_LZBMP:
+            bmp = item->dat;
+            return sizeof(BITMAP) + (long)bmp->h * (
+                sizeof(unsigned char *) +
+                bmp->w * ((bitmap_color_depth(bmp) + 7) / 8)
+            );
+        case DAT_RLE_SPRITE:
+            rle = item->dat;
+            return sizeof(RLE_SPRITE) + rle->size;
+        case DAT_C_SPRITE:
+        case DAT_XC_SPRITE:
+            cspr = item->dat;
+            size = sizeof(COMPILED_SPRITE);
+            for (a = 0; a < 4; ++a) {
+                if (cspr->proc[a].draw) {
+                    size += cspr->proc[a].len;
+                }
+            }
+            return size;
+        case DAT_PALETTE:
+            return sizeof(PALETTE);
+        case DAT_ATLAS:
+            return ((SPR_ATLAS *)item->dat)->size;
+        case DAT_GLYPHS:
+            return sizeof(TXT_GLYPHSET) +
+                ((TXT_GLYPHSET *)item->dat)->span_n * sizeof(TXT_SPAN);
+    }
+    return item->size;
+}
+
+/**
+ * Returns the estimated number of bytes of memory used by an object,
+ * or 0 if it isn't loaded.
+ */
+long pack_obj_mem(int obj) {
+    return pack_mem[obj];
+}
+
+/**
+ * Returns the estimated number of bytes used by all loaded objects.
+ */
+long pack_mem_resident() {
+    return pack_resident;
+}
+
+/**
+ * Returns the highest number of bytes that were ever in use at once.
+ */
+long pack_mem_peak() {
+    return pack_peak;
+}
+
+/**
+ * Lets objects of a type be read in parts by pack_read_begin(), and
+ * from the open pack by pack_load_obj(). The load function is the same
+ * one that's passed to register_datafile_object(). Only used for our
+ * own baked types, which are stored uncompressed.
+ */
+void pack_register_type(int type, PACK_LOAD_FN load) {
+    if (pack_type_count == PACK_TYPES_MAX) {
+        return;
+    }
+    pack_types[pack_type_count] = type;
+    pack_loaders[pack_type_count] = load;
+    pack_type_count += 1;
+}
+
+/**
+ * Frees a property list read by pack_read_props().
+ */
+static void free_props(DATAFILE_PROPERTY *prop) {
+    int a;
+
+    if (!prop) {
+        return;
+    }
+    for (a = 0; prop[a].type != DAT_END; ++a) {
+        free(prop[a].dat);
+    }
+    free(prop);
+}
+
+/**
+ * Reads the properties of an object, followed by its type. The list is
+ * allocated the same way Allegro does it, so that it's freed along with
+ * the object by unload_datafile_object().
+ * Returns false if the pack can't be read.
+ */
+static bool pack_read_props(PACK_READ *rd, long *type) {
+    DATAFILE_PROPERTY *list;
+    long prop_type, size;
+    char *dat;
+    int n = 0;
+
+    rd->prop = NULL;
+    while (pack_read_mgetl(type)) {
+        if (*type != DAT_PROPERTY) {
+            return true;
+        }
+        if (!pack_read_mgetl(&prop_type) || !pack_read_mgetl(&size) ||
+            size < 0) {
+            break;
+        }
+        list = realloc(rd->prop, (n + 2) * sizeof(DATAFILE_PROPERTY));
+        if (!list) {
+            break;
+        }
+        rd->prop = list;
+        list[n].dat = NULL;
+        list[n].type = DAT_END;
+        dat = malloc(size + 1);
+        if (!dat || !pack_read(dat, size)) {
+            free(dat);
+            break;
+        }
+        dat[size] = '\0';
+        list[n].dat = dat;
+        list[n].type = prop_type;
+        n += 1;
+        list[n].dat = NULL;
+        list[n].type = DAT_END;
+    }
+    free_props(rd->prop);
+    rd->prop = NULL;
+    return false;
+}
+
+/**
+ * Starts reading an object from the pack in parts, so that the work can be
+ * spread out over several frames. Reads the object's properties and header,
+ * but none of its data; call pack_read_step() until all of it is read,
+ * then pack_read_end() to make the object.
+ *
+ * Returns false if the object's type wasn't registered with
+ * pack_register_type(), if it's compressed, or if the pack can't be read.
+ * Such objects have to be loaded in one go with pack_load_obj().
+ */
+bool pack_read_begin(PACK_READ *rd, int obj) {
+    long type, stored, size;
+    int a;
+
+    rd->obj = obj;
+    rd->buf = NULL;
+    rd->prop = NULL;
+    if (!pack_seek(pack_index->offset[obj]) || !pack_read_props(rd, &type)) {
+        return false;
+    }
+    for (a = 0; a < pack_type_count; ++a) {
+        if (pack_types[a] == type) {
+            break;
+        }
+    }
+    // The data's size is negative if the object is compressed.
+    if (a == pack_type_count || !pack_read_mgetl(&stored) ||
+        !pack_read_mgetl(&size) || size < 0) {
+        pack_read_abort(rd);
+        return false;
+    }
+    rd->type = type;
+    rd->load = pack_loaders[a];
+    rd->start = pack_file_pos;
+    rd->size = size;
+    rd->pos = 0;
+    rd->buf = malloc(MAX(1, size));
+    if (!rd->buf) {
+        pack_read_abort(rd);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Reads up to max bytes of an object's data. Other objects may be read in
+ * between, so this seeks to where the last step left off.
+ * Returns the number of bytes read, which is 0 once all data is in,
+ * or -1 if the pack can't be read.
+ */
+long pack_read_step(PACK_READ *rd, long max) {
+    long n = MIN(max, rd->size - rd->pos);
+
+    if (n > 0 && (!pack_seek(rd->start + rd->pos) ||
+        !pack_read(rd->buf + rd->pos, n))) {
+        return -1;
+    }
+    rd->pos += n;
+    return n;
+}
+
+/**
+ * Makes the object out of the data that was read, and adds it to the pack
+ * as if it were loaded by pack_load_obj(). Its data is freed afterwards.
+ * Returns false if the object couldn't be made.
+ */
+bool pack_read_end(PACK_READ *rd) {
+    PACK_MEMFILE mem;
+    PACKFILE *f = NULL;
+    DATAFILE *item;
+
+    // The object may have been loaded in one go in the meantime.
+    if (pack_objs[rd->obj]) {
+        pack_read_abort(rd);
+        pack_refs[rd->obj] += 1;
+        return true;
+    }
+    mem.buf = rd->buf;
+    mem.size = rd->pos;
+    mem.pos = 0;
+    item = malloc(sizeof(DATAFILE));
+    if (item) {
+        f = pack_fopen_vtable(&pack_memfile_vtable, &mem);
+    }
+    if (f) {
+        item->dat = rd->load(f, rd->size);
+        pack_fclose(f);
+    }
+    if (!f || !item->dat) {
+        free(item);
+        pack_read_abort(rd);
+        return false;
+    }
+    item->type = rd->type;
+    item->size = rd->size;
+    item->prop = rd->prop;
+    rd->prop = NULL;
+    pack_read_abort(rd);
+    pack_install_obj(rd->obj, item);
+    return true;
+}
+
+/**
+ * Stops reading an object in parts, and frees what was read so far.
+ */
+void pack_read_abort(PACK_READ *rd) {
+    free(rd->buf);
+    free_props(rd->prop);
+    rd->buf = NULL;
+    rd->prop = NULL;
+}
+
+/**
+ * Adds a loaded object to the pack, used once.
+ */
+static void pack_install_obj(int obj, DATAFILE *item) {
+    pack_objs[obj] = item;
+    pack_refs[obj] = 1;
+    pack_data[obj] = *item;
+    pack_mem[obj] = obj_mem_size(item);
+    pack_resident += pack_mem[obj];
+    if (pack_resident > pack_peak) {
+        pack_peak = pack_resident;
+    }
+}
+
+/**
+ * Loads a single object from the pack by seeking to its offset.
+ * Returns false if the object couldn't be loaded.
+ *
+ * Objects of our own baked types are read from the open pack. Other types,
+ * i.e. palettes and fonts, are loaded by Allegro, which opens the pack
+ * again for every object; these are all small.
+ *
+ * Objects are reference counted: if the object is already loaded,
+ * it's only marked as being used once more. Every successful call
+ * must be matched by a call to pack_unload_obj().
+ */
+bool pack_load_obj(int obj) {
+    PACK_READ rd;
+    DATAFILE *item;
+
+    if (pack_objs[obj]) {
+        pack_refs[obj] += 1;
+        return true;
+    }
+    if (pack_read_begin(&rd, obj)) {
+        if (pack_read_step(&rd, rd.size) != rd.size) {
+            pack_read_abort(&rd);
+            return false;
+        }
+        return pack_read_end(&rd);
+    }
+    item = load_datafile_object_indexed(pack_index, obj);
+    if (!item) {
+        return false;
+    }
+    pack_install_obj(obj, item);
+    return true;
+}
+
+/**
+ * Indicates an object loaded with pack_load_obj() is no longer needed.
+ * It's unloaded once nothing uses it anymore.
+ */
+void pack_unload_obj(int obj) {
+    if (!pack_objs[obj]) {
+        return;
+    }
+    pack_refs[obj] -= 1;
+    if (pack_refs[obj] == 0) {
+        pack_destroy_obj(obj);
+    }
+}
+
+/**
+ * Packfile functions for reading an object's data from memory.
+ * The data is only ever read, from front to back.
+ */
+static int memfile_fclose(void *userdata) {
+    return 0;
+}
+
+static int memfile_getc(void *userdata) {
+    PACK_MEMFILE *mem = userdata;
+
+    return mem->pos < mem->size ? mem->buf[mem->pos++] : EOF;
+}
+
+static int memfile_ungetc(int c, void *userdata) {
+    PACK_MEMFILE *mem = userdata;
+
+    if (mem->pos == 0) {
+        return EOF;
+    }
+    mem->buf[--mem->pos] = c;
+    return c;
+}
+
+static long memfile_fread(void *p, long n, void *userdata) {
+    PACK_MEMFILE *mem = userdata;
+
+    n = MAX(0, MIN(n, mem->size - mem->pos));
+    memcpy(p, mem->buf + mem->pos, n);
+    mem->pos += n;
+    return n;
+}
+
+static int memfile_putc(int c, void *userdata) {
+    return EOF;
+}
+
+static long memfile_fwrite(const void *p, long n, void *userdata) {
+    return 0;
+}
+
+static int memfile_fseek(void *userdata, int offset) {
+    PACK_MEMFILE *mem = userdata;
+
+    if (offset < 0 || offset > mem->size - mem->pos) {
+        return -1;
+    }
+    mem->pos += offset;
+    return 0;
+}
+
+static int memfile_feof(void *userdata) {
+    PACK_MEMFILE *mem = userdata;
+
+    return mem->pos >= mem->size;
+}
+
+static int memfile_ferror(void *userdata) {
+    return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GFX_DEPS_PACK__
+#define __CEEGEE_GFX_DEPS_PACK__
+
+#include "src/gfx/res/data/pack_data.h"
+
+// Allegro's index offsets include the 4-byte magic at the start of the
+// file, which pack_fopen() reads by itself.
+#define PACK_MAGIC_SIZE 4
+// Maximum number of object types that can be read in parts.
+#define PACK_TYPES_MAX 8
+
+// Function that makes an object out of its data, like the load functions
+// passed to register_datafile_object().
+typedef void *(*PACK_LOAD_FN)(PACKFILE *f, long size);
+
+// Object that's being read from the pack in parts; see pack_read_begin().
+// Its data is size bytes long and starts at start in the pack. pos is
+// the number of bytes that have been read into buf so far. prop is the
+// object's property list, which is read right away.
+typedef struct PACK_READ {
+    int obj;
+    int type;
+    PACK_LOAD_FN load;
+    DATAFILE_PROPERTY *prop;
+    long start, size, pos;
+    unsigned char *buf;
+} PACK_READ;
+
+// Block of memory that's read through a PACKFILE by the load functions.
+typedef struct PACK_MEMFILE {
+    unsigned char *buf;
+    long size, pos;
+} PACK_MEMFILE;
+
+extern char PACK_PATH[];
+extern DATAFILE_INDEX *pack_index;
+
+DATAFILE *pack_ref();
+bool pack_load_obj(int obj);
+bool pack_obj_loaded(int obj);
+bool pack_read_begin(PACK_READ *rd, int obj);
+bool pack_read_end(PACK_READ *rd);
+static bool pack_read(void *buf, long n);
+static bool pack_read_mgetl(long *l);
+static bool pack_read_props(PACK_READ *rd, long *type);
+static bool pack_seek(long offset);
+int pack_count();
+int pack_open(char *path);
+long pack_mem_peak();
+long pack_mem_resident();
+long pack_obj_mem(int obj);
+long pack_obj_offset(int obj);
+long pack_read_step(PACK_READ *rd, long max);
+static int memfile_fclose(void *userdata);
+static int memfile_feof(void *userdata);
+static int memfile_ferror(void *userdata);
+static int memfile_fseek(void *userdata, int offset);
+static int memfile_getc(void *userdata);
+static int memfile_putc(int c, void *userdata);
+static int memfile_ungetc(int c, void *userdata);
+static long memfile_fread(void *p, long n, void *userdata);
+static long memfile_fwrite(const void *p, long n, void *userdata);
+static long obj_mem_size(DATAFILE *item);
+static void free_props(DATAFILE_PROPERTY *prop);
+static void pack_destroy_obj(int obj);
+static void pack_install_obj(int obj, DATAFILE *item);
+void pack_close();
+void pack_read_abort(PACK_READ *rd);
+void pack_register_type(int type, PACK_LOAD_FN load);
+void pack_unload_obj(int obj);
+
+#endif
@@ -3,19 +3,34 @@
  * MIT License
  */
 
+#include "src/gfx/deps/atlas.h"
+#include "src/gfx/deps/lzbmp.h"
+#include "src/gfx/deps/pack.h"
+#include "src/gfx/glyphs.h"
 #include "src/gfx/res/flim.h"
 #include "src/gfx/res/logos.h"
 #include "src/gfx/res/tin.h"
 #include "src/gfx/res/usp_talon.h"
 
 /**
- * Asks every resource to register itself.
+ * Opens the resource pack and asks every resource to register itself.
+ * Returns 1 if the pack is missing or can't be read, 0 otherwise.
  */
-void register_resources() {
+int register_resources() {
+    // Custom object types must be known before anything is loaded.
+    atlas_register();
+    glyphs_register();
+    lzbmp_register();
+    if (pack_open(PACK_PATH) != 0) {
+        return 1;
+    }
+
     usp_talon_register();
     logos_register();
 
     // Fonts:
     flim_register();
     tin_register();
+
+    return 0;
 }
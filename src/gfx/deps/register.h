@@ -6,6 +6,6 @@
 #ifndef __CEEGEE_GFX_DEPS_REGISTER__
 #define __CEEGEE_GFX_DEPS_REGISTER__
 
-void register_resources();
+int register_resources();
 
 #endif
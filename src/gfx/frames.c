@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "src/gfx/frames.h"
+#include "src/gfx/masks.h"
+
+/**
+ * Compiles a sprite. Compiled sprites are made from bitmaps,
+ * so the sprite is drawn into a temporary one first.
+ */
+static COMPILED_SPRITE *frame_compile(RLE_SPRITE *rle) {
+    COMPILED_SPRITE *cspr;
+    BITMAP *bmp = create_bitmap_ex(rle->color_depth, rle->w, rle->h);
+
+    if (!bmp) {
+        return NULL;
+    }
+    clear_to_color(bmp, bitmap_mask_color(bmp));
+    draw_rle_sprite(bmp, rle, 0, 0);
+    cspr = get_compiled_sprite(bmp, FALSE);
+    destroy_bitmap(bmp);
+    return cspr;
+}
+
+/**
+ * Creates a frame for a sprite, compiles it and generates its collision mask.
+ * Should be called from a resource's callback, so that this happens
+ * once per load. Returns NULL if there isn't enough memory.
+ */
+SPR_FRAME *frame_create(RLE_SPRITE *rle) {
+    SPR_FRAME *frame = malloc(sizeof(SPR_FRAME));
+
+    if (!frame) {
+        return NULL;
+    }
+    frame->w = rle->w;
+    frame->h = rle->h;
+    frame->rle = rle;
+    frame->cspr = frame_compile(rle);
+    frame->mask = mask_create(rle);
+    if (!frame->mask) {
+        frame_destroy(frame);
+        return NULL;
+    }
+    return frame;
+}
+
+/**
+ * Frees a frame and everything generated for it, but not its sprite.
+ */
+void frame_destroy(SPR_FRAME *frame) {
+    if (!frame) {
+        return;
+    }
+    if (frame->cspr) {
+        destroy_compiled_sprite(frame->cspr);
+    }
+    mask_destroy(frame->mask);
+    free(frame);
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GFX_FRAMES__
+#define __CEEGEE_GFX_FRAMES__
+
+#include "src/gfx/masks.h"
+
+// A sprite frame as used by the game: the sprite itself, along with
+// everything derived from it when its resource is loaded.
+// The sprite belongs to the resource; the rest belongs to the frame.
+// Compiled sprites are faster to draw, but can't be clipped, so they're
+// only used when the whole frame is inside the clip rectangle.
+// cspr is NULL if the frame couldn't be compiled.
+//
+// A compiled sprite is machine code allocated by Allegro, so unlike rle
+// it can't be placed inside the atlas. Frames that are entirely on the
+// screen, which is most of them, are drawn without touching the atlas at
+// all; the atlas only saves the read at load time and keeps the RLE data
+// used for clipped frames and collision masks together. That's the price
+// of using compiled sprites, which are Allegro's fastest way to draw.
+typedef struct SPR_FRAME {
+    int w, h;
+    RLE_SPRITE *rle;
+    COMPILED_SPRITE *cspr;
+    COL_MASK *mask;
+} SPR_FRAME;
+
+SPR_FRAME *frame_create(RLE_SPRITE *rle);
+static COMPILED_SPRITE *frame_compile(RLE_SPRITE *rle);
+void frame_destroy(SPR_FRAME *frame);
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "src/gfx/deps/pack.h"
+#include "src/gfx/glyphs.h"
+
+/**
+ * Loads a GLY object from the pack and returns it as a TXT_GLYPHSET.
+ *
+ * Our fonts consist of a main layer and a shadow layer, which are normally
+ * drawn on top of each other in two colors. tools/glyphbake merges them
+ * when the pack is built, and stores every glyph as spans that record
+ * which layer ended up on top.
+ *
+ * The object starts with the height (16 bits), the number of glyphs
+ * (16 bits) and the total number of spans (32 bits), followed by the
+ * width and number of spans of every glyph (16 bits each). Then come the
+ * spans of all glyphs, in order, four bytes each, in the same layout as
+ * TXT_SPAN; they're read straight into place, after the set itself.
+ */
+static void *load_glyphs(PACKFILE *f, long size) {
+    TXT_GLYPHSET *set;
+    TXT_SPAN *span;
+    int w[GLYPH_COUNT], span_n[GLYPH_COUNT];
+    int a, h, n;
+    long total, sum = 0;
+
+    h = pack_igetw(f);
+    n = pack_igetw(f);
+    total = pack_igetl(f);
+    if (h <= 0 || n != GLYPH_COUNT || total < 0) {
+        return NULL;
+    }
+    for (a = 0; a < GLYPH_COUNT; ++a) {
+        w[a] = pack_igetw(f);
+        span_n[a] = pack_igetw(f);
+        sum += span_n[a];
+    }
+    if (sum != total) {
+        return NULL;
+    }
+
+    set = malloc(sizeof(TXT_GLYPHSET) + total * sizeof(TXT_SPAN));
+    if (!set) {
+        return NULL;
+    }
+    set->h = h;
+    set->span_n = total;
+    set->spans = (TXT_SPAN *)(set + 1);
+    if (pack_fread(set->spans, total * sizeof(TXT_SPAN), f) !=
+        total * (long)sizeof(TXT_SPAN)) {
+        free(set);
+        return NULL;
+    }
+    span = set->spans;
+    for (a = 0; a < GLYPH_COUNT; ++a) {
+        set->glyphs[a].w = w[a];
+        set->glyphs[a].span_n = span_n[a];
+        set->glyphs[a].spans = span;
+        span += span_n[a];
+    }
+    // A bad color would make draw_glyphs() read outside its color table.
+    for (a = 0; a < total; ++a) {
+        if (set->spans[a].color != GLYPH_COLOR_A &&
+            set->spans[a].color != GLYPH_COLOR_B) {
+            free(set);
+            return NULL;
+        }
+    }
+    return set;
+}
+
+/**
+ * Frees a GLY object. The spans are part of the same block.
+ */
+static void destroy_glyphs(void *data) {
+    free(data);
+}
+
+/**
+ * Lets Allegro load GLY objects from datafiles, and lets the pack read
+ * them in parts. Must be called before any objects are loaded from
+ * the pack.
+ */
+void glyphs_register() {
+    register_datafile_object(DAT_GLYPHS, load_glyphs, destroy_glyphs);
+    pack_register_type(DAT_GLYPHS, load_glyphs);
+}
+
+/**
+ * Returns the width of a string in pixels.
+ */
+int glyphs_length(TXT_GLYPHSET *set, char *txt) {
+    unsigned char c;
+    int w = 0;
+
+    while ((c = *txt++) != 0) {
+        if (c >= GLYPH_FIRST && c <= GLYPH_LAST) {
+            w += set->glyphs[c - GLYPH_FIRST].w;
+        }
+    }
+    return w;
+}
+
+/**
+ * Draws a string in a single pass, using both colors at once.
+ *
+ * Every glyph is drawn as a list of spans. On 8-bit memory bitmaps,
+ * the spans are written straight to the bitmap's lines with memset().
+ * Other bitmaps, such as the screen, get an hline() per span.
+ *
+ * Clipping is done once per string: if the whole string fits inside
+ * the clipping rectangle, no further checks are made. Otherwise, each
+ * span is cut off at the edges of the rectangle. The string is drawn
+ * left aligned at x and y.
+ */
+void draw_glyphs(BITMAP *buffer, TXT_GLYPHSET *set, char *txt, int x, int y,
+    int color_a, int color_b)
+{
+    TXT_GLYPH *glyph;
+    TXT_SPAN *span;
+    int colors[3] = { 0, color_a, color_b };
+    bool direct = is_memory_bitmap(buffer) &&
+        bitmap_color_depth(buffer) == 8;
+    bool clip;
+    int cl = 0, cr = buffer->w, ct = 0, cb = buffer->h;
+    int a, x1, x2, sy;
+    unsigned char c;
+
+    if (buffer->clip) {
+        cl = buffer->cl;
+        cr = buffer->cr;
+        ct = buffer->ct;
+        cb = buffer->cb;
+    }
+
+    // Nothing to do if the string is above or below the clipping rectangle.
+    if (y >= cb || y + set->h <= ct || x >= cr) {
+        return;
+    }
+    clip = x < cl || x + glyphs_length(set, txt) > cr || y < ct ||
+        y + set->h > cb;
+
+    while ((c = *txt++) != 0) {
+        if (c < GLYPH_FIRST || c > GLYPH_LAST) {
+            continue;
+        }
+        glyph = &set->glyphs[c - GLYPH_FIRST];
+        span = glyph->spans;
+        for (a = 0; a < glyph->span_n; ++a, ++span) {
+            x1 = x + span->x;
+            x2 = x1 + span->len;
+            sy = y + span->y;
+            if (clip) {
+                if (sy < ct || sy >= cb) {
+                    continue;
+                }
+                x1 = MAX(x1, cl);
+                x2 = MIN(x2, cr);
+                if (x1 >= x2) {
+                    continue;
+                }
+            }
+            if (direct) {
+                memset(buffer->line[sy] + x1, colors[span->color], x2 - x1);
+            }
+            else {
+                hline(buffer, x1, sy, x2 - 1, colors[span->color]);
+            }
+        }
+        x += glyph->w;
+    }
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GFX_GLYPHS__
+#define __CEEGEE_GFX_GLYPHS__
+
+// Datafile object type for glyph sets baked by tools/glyphbake.
+#define DAT_GLYPHS DAT_ID('G', 'L', 'Y', ' ')
+
+// Range of characters in a glyph set.
+#define GLYPH_FIRST 32
+#define GLYPH_LAST 126
+#define GLYPH_COUNT (GLYPH_LAST - GLYPH_FIRST + 1)
+
+// Pixel values in a glyph: transparent, or one of the two font layers.
+#define GLYPH_CLEAR 0
+#define GLYPH_COLOR_A 1
+#define GLYPH_COLOR_B 2
+
+// Horizontal run of pixels of a single color in a glyph.
+// color is GLYPH_COLOR_A or GLYPH_COLOR_B.
+typedef struct TXT_SPAN {
+    unsigned char x, y, len, color;
+} TXT_SPAN;
+
+// A single glyph; spans points into the glyph set's span atlas.
+typedef struct TXT_GLYPH {
+    int w;
+    int span_n;
+    TXT_SPAN *spans;
+} TXT_GLYPH;
+
+// Both layers of a two-tone font, merged into a single set of glyphs.
+// The spans of all glyphs are stored after each other, right after
+// the set itself, in one block.
+typedef struct TXT_GLYPHSET {
+    int h;
+    int span_n;
+    TXT_GLYPH glyphs[GLYPH_COUNT];
+    TXT_SPAN *spans;
+} TXT_GLYPHSET;
+
+int glyphs_length(TXT_GLYPHSET *set, char *txt);
+static void *load_glyphs(PACKFILE *f, long size);
+static void destroy_glyphs(void *data);
+void glyphs_register();
+void draw_glyphs(BITMAP *buffer, TXT_GLYPHSET *set, char *txt, int x, int y,
+    int color_a, int color_b);
+
+#endif
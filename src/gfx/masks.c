@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "src/gfx/masks.h"
+
+/**
+ * Creates a collision mask from a sprite. Every pixel that isn't the mask
+ * color is solid. The sprite is drawn into a temporary bitmap to read its
+ * pixels, so this should only be done when the sprite is loaded.
+ * Returns NULL if there isn't enough memory.
+ */
+COL_MASK *mask_create(RLE_SPRITE *sprite) {
+    COL_MASK *mask;
+    BITMAP *bmp;
+    unsigned long *row;
+    int x, y, mask_color;
+
+    bmp = create_bitmap_ex(sprite->color_depth, sprite->w, sprite->h);
+    if (!bmp) {
+        return NULL;
+    }
+    mask = malloc(sizeof(COL_MASK));
+    if (!mask) {
+        destroy_bitmap(bmp);
+        return NULL;
+    }
+    mask->w = sprite->w;
+    mask->h = sprite->h;
+    mask->words = (sprite->w + MASK_WORD_BITS - 1) / MASK_WORD_BITS;
+    mask->bits = calloc(mask->words * sprite->h, sizeof(unsigned long));
+    if (!mask->bits) {
+        free(mask);
+        destroy_bitmap(bmp);
+        return NULL;
+    }
+
+    mask_color = bitmap_mask_color(bmp);
+    clear_to_color(bmp, mask_color);
+    draw_rle_sprite(bmp, sprite, 0, 0);
+    for (y = 0; y < mask->h; ++y) {
+        row = &mask->bits[y * mask->words];
+        for (x = 0; x < mask->w; ++x) {
+            if (getpixel(bmp, x, y) != mask_color) {
+                row[x / MASK_WORD_BITS] |=
+                    1UL << (MASK_WORD_BITS - 1 - x % MASK_WORD_BITS);
+            }
+        }
+    }
+    destroy_bitmap(bmp);
+    return mask;
+}
+
+/**
+ * Frees a collision mask.
+ */
+void mask_destroy(COL_MASK *mask) {
+    if (!mask) {
+        return;
+    }
+    free(mask->bits);
+    free(mask);
+}
+
+/**
+ * Returns one word's worth of bits from a row of a mask, starting at
+ * pixel x. x may be negative or past the end of the row; pixels outside
+ * of the row are empty.
+ */
+static unsigned long mask_word(unsigned long *row, int words, int x) {
+    int n, shift;
+
+    if (x <= -MASK_WORD_BITS || x >= words * MASK_WORD_BITS) {
+        return 0;
+    }
+    if (x < 0) {
+        return row[0] >> -x;
+    }
+    n = x / MASK_WORD_BITS;
+    shift = x % MASK_WORD_BITS;
+    if (shift == 0) {
+        return row[n];
+    }
+    return (row[n] << shift) |
+        (n + 1 < words ? row[n + 1] >> (MASK_WORD_BITS - shift) : 0);
+}
+
+/**
+ * Returns whether two masks at the given positions have any solid pixels
+ * in common. Only the rows and words where the masks overlap are checked,
+ * and each check compares a whole word of pixels at once: the words of b
+ * are shifted to line up with the words of a, and then ANDed together.
+ */
+bool mask_collide(COL_MASK *a, int ax, int ay, COL_MASK *b, int bx, int by) {
+    int x1 = MAX(ax, bx) - ax;
+    int x2 = MIN(ax + a->w, bx + b->w) - ax;
+    int y1 = MAX(ay, by) - ay;
+    int y2 = MIN(ay + a->h, by + b->h) - ay;
+    int dx = ax - bx;
+    unsigned long *row_a, *row_b, bits;
+    int y, n, n1, n2;
+
+    if (x1 >= x2 || y1 >= y2) {
+        return false;
+    }
+    n1 = x1 / MASK_WORD_BITS;
+    n2 = (x2 - 1) / MASK_WORD_BITS;
+    for (y = y1; y < y2; ++y) {
+        row_a = &a->bits[y * a->words];
+        row_b = &b->bits[(y + ay - by) * b->words];
+        for (n = n1; n <= n2; ++n) {
+            if (!row_a[n]) {
+                continue;
+            }
+            bits = mask_word(row_b, b->words, n * MASK_WORD_BITS + dx);
+            if (row_a[n] & bits) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GFX_MASKS__
+#define __CEEGEE_GFX_MASKS__
+
+// Masks are stored in words of the platform's native size: 32 bits on DOS,
+// and 64 bits on most other hosts. The leftmost pixel is the highest bit.
+#define MASK_WORD_BITS ((int)(sizeof(unsigned long) * CHAR_BIT))
+
+// 1-bit collision mask of a sprite. Every row is stored in the same number
+// of words; bits past the sprite's width are always zero.
+typedef struct COL_MASK {
+    int w, h;
+    int words;
+    unsigned long *bits;
+} COL_MASK;
+
+COL_MASK *mask_create(RLE_SPRITE *sprite);
+bool mask_collide(COL_MASK *a, int ax, int ay, COL_MASK *b, int bx, int by);
+static unsigned long mask_word(unsigned long *row, int words, int x);
+void mask_destroy(COL_MASK *mask);
+
+#endif
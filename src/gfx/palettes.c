@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "src/gfx/palettes.h"
+
+// Ticks of the palette timer since it was installed.
+volatile int pal_ticks = 0;
+
+// The palette as it was last uploaded.
+PALETTE pal_curr;
+
+// The fade in progress: the palettes it goes from and to, and the
+// difference between them per color component. The fade started at
+// tick pal_fade_start and lasts pal_fade_len ticks.
+PALETTE pal_from;
+PALETTE pal_to;
+signed char pal_delta[PAL_SIZE][3];
+int pal_fade_start;
+int pal_fade_len;
+bool pal_fade_active = false;
+
+// How far each possible difference has come at the current step of the
+// fade, indexed by the difference plus PAL_DELTA_MAX.
+signed char pal_lerp[PAL_DELTA_MAX * 2 + 1];
+
+// Palette cycles, in no particular order. Inactive ones are free.
+PAL_CYCLE pal_cycles[PAL_CYCLES_MAX];
+
+/**
+ * Timer callback that counts palette ticks.
+ */
+static void pal_tick() {
+    ++pal_ticks;
+}
+END_OF_STATIC_FUNCTION(pal_tick)
+
+/**
+ * Installs the palette timer. Used once at the start, after Allegro's
+ * timer has been installed.
+ */
+void pal_init() {
+    LOCK_VARIABLE(pal_ticks);
+    LOCK_FUNCTION(pal_tick);
+    install_int_ex(pal_tick, BPS_TO_TIMER(PAL_TICKS_PER_SEC));
+    get_palette(pal_curr);
+}
+
+/**
+ * Uploads the entries of a palette that differ from the ones that were
+ * last uploaded. Consecutive entries that changed are uploaded together.
+ */
+static void pal_upload(RGB *pal) {
+    int a = 0, start;
+
+    while (a < PAL_SIZE) {
+        if (pal[a].r == pal_curr[a].r && pal[a].g == pal_curr[a].g &&
+            pal[a].b == pal_curr[a].b) {
+            ++a;
+            continue;
+        }
+        start = a;
+        while (a < PAL_SIZE && (pal[a].r != pal_curr[a].r ||
+            pal[a].g != pal_curr[a].g || pal[a].b != pal_curr[a].b)) {
+            pal_curr[a] = pal[a];
+            ++a;
+        }
+        set_palette_range(pal_curr, start, a - 1, FALSE);
+    }
+}
+
+/**
+ * Sets the palette right away, stopping any fade in progress.
+ * Used instead of set_palette() by code that also fades the palette.
+ */
+void pal_set(RGB *pal) {
+    pal_fade_active = false;
+    get_palette(pal_curr);
+    pal_upload(pal);
+}
+
+/**
+ * Starts fading from the current palette to another one over a number of
+ * milliseconds. The fade happens in pal_update(), so the game keeps running
+ * in the meantime; see pal_fading() to find out when it's done.
+ */
+void pal_fade_to(RGB *to, int ms) {
+    int a;
+
+    // The palette may have been set by something else since the last
+    // upload, so start from what's actually on the screen.
+    get_palette(pal_curr);
+    if (ms <= 0) {
+        pal_set(to);
+        return;
+    }
+    for (a = 0; a < PAL_SIZE; ++a) {
+        pal_from[a] = pal_curr[a];
+        pal_to[a] = to[a];
+        pal_delta[a][0] = to[a].r - pal_curr[a].r;
+        pal_delta[a][1] = to[a].g - pal_curr[a].g;
+        pal_delta[a][2] = to[a].b - pal_curr[a].b;
+    }
+    pal_fade_start = pal_ticks;
+    pal_fade_len = MAX(1, (ms * PAL_TICKS_PER_SEC) / 1000);
+    pal_fade_active = true;
+}
+
+/**
+ * Starts fading the current palette to black.
+ */
+void pal_fade_out(int ms) {
+    pal_fade_to(black_palette, ms);
+}
+
+/**
+ * Returns whether a fade is in progress.
+ */
+bool pal_fading() {
+    return pal_fade_active;
+}
+
+/**
+ * Starts rotating the colors of n palette entries from first onward.
+ * The colors are taken from a palette, which should be the one that's
+ * on the screen. Every ms milliseconds, the colors move stride entries
+ * forward or backward; a stride other than 1 rotates groups of entries,
+ * e.g. a set of hues with a few shades each.
+ * Returns the cycle's ID, or -1 if there are too many cycles.
+ */
+int pal_cycle_add(RGB *pal, int first, int n, int stride, int ms, int dir) {
+    PAL_CYCLE *cycle;
+    int a, b;
+
+    for (a = 0; a < PAL_CYCLES_MAX; ++a) {
+        if (!pal_cycles[a].active) {
+            break;
+        }
+    }
+    if (a == PAL_CYCLES_MAX) {
+        return -1;
+    }
+    cycle = &pal_cycles[a];
+    cycle->first = MID(0, first, PAL_SIZE - 1);
+    cycle->n = MID(1, n, PAL_SIZE - cycle->first);
+    cycle->stride = MID(1, stride, cycle->n);
+    cycle->dir = dir < 0 ? PAL_CYCLE_BACKWARD : PAL_CYCLE_FORWARD;
+    cycle->ticks = MAX(1, (ms * PAL_TICKS_PER_SEC) / 1000);
+    cycle->next = pal_ticks + cycle->ticks;
+    cycle->pos = 0;
+    for (b = 0; b < cycle->n; ++b) {
+        cycle->colors[b] = pal[cycle->first + b];
+    }
+    cycle->active = true;
+    get_palette(pal_curr);
+    return a;
+}
+
+/**
+ * Stops a palette cycle. Its entries keep the colors they have.
+ */
+void pal_cycle_remove(int id) {
+    if (id >= 0 && id < PAL_CYCLES_MAX) {
+        pal_cycles[id].active = false;
+    }
+}
+
+/**
+ * Stops all palette cycles.
+ */
+void pal_cycle_clear() {
+    int a;
+
+    for (a = 0; a < PAL_CYCLES_MAX; ++a) {
+        pal_cycles[a].active = false;
+    }
+}
+
+/**
+ * Rotates a cycle's colors by as many steps as are due, and writes them
+ * into a palette. If the game fell behind, the missed steps are skipped
+ * rather than caught up on one by one.
+ * Returns false if no step was due.
+ */
+static bool pal_cycle_step(PAL_CYCLE *cycle, RGB *pal) {
+    int a, steps, src, late = pal_ticks - cycle->next;
+
+    if (late < 0) {
+        return false;
+    }
+    steps = 1 + late / cycle->ticks;
+    cycle->next += steps * cycle->ticks;
+    cycle->pos -= cycle->dir * ((steps * cycle->stride) % cycle->n);
+    cycle->pos = (cycle->pos % cycle->n + cycle->n) % cycle->n;
+
+    src = cycle->pos;
+    for (a = 0; a < cycle->n; ++a) {
+        pal[cycle->first + a] = cycle->colors[src];
+        if (++src == cycle->n) {
+            src = 0;
+        }
+    }
+    return true;
+}
+
+/**
+ * Advances the fade in progress, or the palette cycles if there's no fade.
+ * Runs once per frame, right after the vertical retrace. How far along
+ * the fade or cycles are depends on the timer, not on the number of frames,
+ * so they take the same time on any machine.
+ *
+ * Every color component goes the same fraction of the way, so rather than
+ * multiplying each of them, the distance for every possible difference is
+ * looked up in a table that's made once per frame.
+ *
+ * Cycles only change their own entries, so only those are uploaded.
+ * They're paused while a fade is in progress.
+ */
+void pal_update() {
+    PALETTE pal;
+    int a, d, step, t;
+    signed char *lerp = pal_lerp + PAL_DELTA_MAX;
+    bool changed = false;
+
+    if (!pal_fade_active) {
+        for (a = 0; a < PAL_CYCLES_MAX; ++a) {
+            if (!pal_cycles[a].active) {
+                continue;
+            }
+            if (!changed) {
+                memcpy(pal, pal_curr, sizeof(PALETTE));
+            }
+            changed |= pal_cycle_step(&pal_cycles[a], pal);
+        }
+        if (changed) {
+            pal_upload(pal);
+        }
+        return;
+    }
+    t = pal_ticks - pal_fade_start;
+    if (t >= pal_fade_len) {
+        pal_fade_active = false;
+        pal_upload(pal_to);
+        return;
+    }
+    step = (t * 256) / pal_fade_len;
+    for (d = -PAL_DELTA_MAX; d <= PAL_DELTA_MAX; ++d) {
+        lerp[d] = (d * step) >> 8;
+    }
+    for (a = 0; a < PAL_SIZE; ++a) {
+        pal[a].r = pal_from[a].r + lerp[pal_delta[a][0]];
+        pal[a].g = pal_from[a].g + lerp[pal_delta[a][1]];
+        pal[a].b = pal_from[a].b + lerp[pal_delta[a][2]];
+        pal[a].filler = 0;
+    }
+    pal_upload(pal);
+}
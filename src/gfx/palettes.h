@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GFX_PALETTES__
+#define __CEEGEE_GFX_PALETTES__
+
+// Rate of the palette timer, which times fades independently of
+// the frame rate.
+#define PAL_TICKS_PER_SEC 100
+// Largest difference between two color components (which go up to 63).
+#define PAL_DELTA_MAX 63
+// Maximum number of palette cycles running at the same time.
+#define PAL_CYCLES_MAX 8
+// Directions in which a cycle rotates its colors.
+#define PAL_CYCLE_FORWARD 1
+#define PAL_CYCLE_BACKWARD (-1)
+
+// Range of palette entries whose colors are rotated on a timer.
+// Every step, the colors move stride entries in direction dir, which
+// happens every ticks palette ticks; next is the tick of the next step.
+// colors holds the range's original colors, and pos is how far they've
+// been rotated.
+typedef struct PAL_CYCLE {
+    bool active;
+    int first, n;
+    int stride, dir;
+    int ticks, next;
+    int pos;
+    RGB colors[PAL_SIZE];
+} PAL_CYCLE;
+
+bool pal_fading();
+int pal_cycle_add(RGB *pal, int first, int n, int stride, int ms, int dir);
+static bool pal_cycle_step(PAL_CYCLE *cycle, RGB *pal);
+static void pal_tick();
+static void pal_upload(RGB *pal);
+void pal_fade_out(int ms);
+void pal_fade_to(RGB *to, int ms);
+void pal_cycle_clear();
+void pal_cycle_remove(int id);
+void pal_init();
+void pal_set(RGB *pal);
+void pal_update();
+
+#endif
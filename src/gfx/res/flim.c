@@ -8,20 +8,40 @@
 
 #include "src/gfx/res/flim.h"
 #include "src/gfx/deps/manager.h"
-#include "src/utils/counters.h"
+#include "src/gfx/glyphs.h"
+#include "src/gfx/textcache.h"
 
 int RES_ID_FLIM;
-char RES_PATH_FLIM[] = "data\\res\\font\\flim.dat";
+// Objects in the resource pack that make up this resource.
+int RES_OBJS_FLIM[] = {
+    FLIM_GLYPHSET
+};
+const int RES_OBJS_FLIM_N = sizeof(RES_OBJS_FLIM) / sizeof(int);
 
 int FLIM_HEIGHT;
+// Both layers of the font, merged together when the pack was built;
+// used to draw text in one pass. Belongs to the pack.
+TXT_GLYPHSET *FLIM_GLYPHS = NULL;
 DATAFILE* data;
 
 void flim_register() {
-    RES_ID_FLIM = res_id();
-    res_register(RES_ID_FLIM, RES_PATH_FLIM, flim_callback);
+    RES_ID_FLIM = res_register(
+        RES_OBJS_FLIM, RES_OBJS_FLIM_N, flim_callback, flim_unload
+    );
 }
 
-void flim_callback() {
+int flim_callback() {
     data = dep_data_ref(RES_ID_FLIM);
-    FLIM_HEIGHT = text_height(data[FLIM_WHITE].dat) - 4;
+    FLIM_GLYPHS = data[FLIM_GLYPHSET].dat;
+    FLIM_HEIGHT = FLIM_GLYPHS->h - 4;
+    // Strings rendered with a previous copy of the font are invalid.
+    text_cache_flush();
+    return 0;
+}
+
+/**
+ * Forgets the glyph set, since it's about to be unloaded.
+ */
+void flim_unload() {
+    FLIM_GLYPHS = NULL;
 }
@@ -8,11 +8,14 @@
 #ifndef __CEEGEE_GFX_RES_FLIM__
 #define __CEEGEE_GFX_RES_FLIM__
 
-#include "src/gfx/res/data/flim_data.h"
+#include "src/gfx/deps/pack.h"
+#include "src/gfx/glyphs.h"
 
 extern int FLIM_HEIGHT;
+extern TXT_GLYPHSET *FLIM_GLYPHS;
 extern int RES_ID_FLIM;
-void flim_callback();
+int flim_callback();
+void flim_unload();
 void flim_register();
 
 #endif
@@ -8,12 +8,14 @@
 
 #include "src/gfx/res/logos.h"
 #include "src/gfx/deps/manager.h"
-#include "src/utils/counters.h"
 
 int RES_ID_LAGAS;
-char RES_PATH_LAGAS[] = "data\\res\\logos.dat";
+// Objects in the resource pack that make up this resource.
+int RES_OBJS_LAGAS[] = {
+    ASLOGO_IMG, ASLOGO_PALETTE, TEST_IMG, TEST_PALETTE
+};
+const int RES_OBJS_LAGAS_N = sizeof(RES_OBJS_LAGAS) / sizeof(int);
 
 void logos_register() {
-    RES_ID_LAGAS = res_id();
-    res_register(RES_ID_LAGAS, RES_PATH_LAGAS, 0);
+    RES_ID_LAGAS = res_register(RES_OBJS_LAGAS, RES_OBJS_LAGAS_N, 0, 0);
 }
@@ -8,7 +8,7 @@
 #ifndef __CEEGEE_GFX_RES_LAGAS__
 #define __CEEGEE_GFX_RES_LAGAS__
 
-#include "src/gfx/res/data/logos_data.h"
+#include "src/gfx/deps/pack.h"
 
 extern int RES_ID_LAGAS;
 void logos_register();
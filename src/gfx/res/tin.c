@@ -8,20 +8,40 @@
 
 #include "src/gfx/res/tin.h"
 #include "src/gfx/deps/manager.h"
-#include "src/utils/counters.h"
+#include "src/gfx/glyphs.h"
+#include "src/gfx/textcache.h"
 
 int RES_ID_TIN;
-char RES_PATH_TIN[] = "data\\res\\font\\tin.dat";
+// Objects in the resource pack that make up this resource.
+int RES_OBJS_TIN[] = {
+    TIN_GLYPHSET
+};
+const int RES_OBJS_TIN_N = sizeof(RES_OBJS_TIN) / sizeof(int);
 
 int TIN_HEIGHT;
+// Both layers of the font, merged together when the pack was built;
+// used to draw text in one pass. Belongs to the pack.
+TXT_GLYPHSET *TIN_GLYPHS = NULL;
 DATAFILE* data;
 
 void tin_register() {
-    RES_ID_TIN = res_id();
-    res_register(RES_ID_TIN, RES_PATH_TIN, tin_callback);
+    RES_ID_TIN = res_register(
+        RES_OBJS_TIN, RES_OBJS_TIN_N, tin_callback, tin_unload
+    );
 }
 
-void tin_callback() {
+int tin_callback() {
     data = dep_data_ref(RES_ID_TIN);
-    TIN_HEIGHT = text_height(data[TIN_WHITE].dat) - 4;
+    TIN_GLYPHS = data[TIN_GLYPHSET].dat;
+    TIN_HEIGHT = TIN_GLYPHS->h - 4;
+    // Strings rendered with a previous copy of the font are invalid.
+    text_cache_flush();
+    return 0;
+}
+
+/**
+ * Forgets the glyph set, since it's about to be unloaded.
+ */
+void tin_unload() {
+    TIN_GLYPHS = NULL;
 }
@@ -8,12 +8,15 @@
 #ifndef __CEEGEE_GFX_RES_TIN__
 #define __CEEGEE_GFX_RES_TIN__
 
-#include "src/gfx/res/data/tin_data.h"
+#include "src/gfx/deps/pack.h"
+#include "src/gfx/glyphs.h"
 
 extern int TIN_HEIGHT;
+extern TXT_GLYPHSET *TIN_GLYPHS;
 extern int RES_ID_TIN;
 void tin_add_palette(RGB *pal);
-void tin_callback();
+int tin_callback();
+void tin_unload();
 void tin_register();
 
 #endif
@@ -7,15 +7,63 @@
 #include <stdio.h>
 
 #include "src/gfx/res/usp_talon.h"
+#include "src/gfx/deps/atlas.h"
 #include "src/gfx/deps/manager.h"
-#include "src/utils/counters.h"
+#include "src/gfx/frames.h"
 
 int RES_ID_USP_TALON;
-char RES_PATH_USP_TALON[] = "data\\res\\usptalon.dat";
+// Objects in the resource pack that make up this resource.
+int RES_OBJS_USP_TALON[] = {
+    USP_TALON_ATLAS, USP_TALON_PALETTE
+};
+const int RES_OBJS_USP_TALON_N = sizeof(RES_OBJS_USP_TALON) / sizeof(int);
 
+// The ship's animation frames, with their collision masks. These are made
+// when the resource is loaded, and freed when it's unloaded.
+SPR_FRAME *USP_TALON_FRAMES[USP_TALON_FRAME_N];
 DATAFILE* data;
 
 void usp_talon_register() {
-    RES_ID_USP_TALON = res_id();
-    res_register(RES_ID_USP_TALON, RES_PATH_USP_TALON, 0);
+    RES_ID_USP_TALON = res_register(
+        RES_OBJS_USP_TALON, RES_OBJS_USP_TALON_N, usp_talon_callback,
+        usp_talon_unload
+    );
+}
+
+/**
+ * Creates the ship's frames from its atlas. Either all frames are made,
+ * or none are: returns 1 if the atlas has too few frames or there isn't
+ * enough memory, in which case the resource isn't loaded.
+ */
+int usp_talon_callback() {
+    SPR_ATLAS *atlas;
+    int a;
+
+    data = dep_data_ref(RES_ID_USP_TALON);
+    atlas = data[USP_TALON_ATLAS].dat;
+    usp_talon_unload();
+    if (atlas->n < USP_TALON_FRAME_N) {
+        return 1;
+    }
+    for (a = 0; a < USP_TALON_FRAME_N; ++a) {
+        USP_TALON_FRAMES[a] = frame_create(atlas->frames[a]);
+        if (!USP_TALON_FRAMES[a]) {
+            usp_talon_unload();
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Frees the ship's frames, which refer to the atlas that's about to be
+ * unloaded.
+ */
+void usp_talon_unload() {
+    int a;
+
+    for (a = 0; a < USP_TALON_FRAME_N; ++a) {
+        frame_destroy(USP_TALON_FRAMES[a]);
+        USP_TALON_FRAMES[a] = NULL;
+    }
 }
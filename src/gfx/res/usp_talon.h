@@ -6,9 +6,22 @@
 #ifndef __CEEGEE_GFX_RES_USP_TALON__
 #define __CEEGEE_GFX_RES_USP_TALON__
 
-#include "src/gfx/res/data/usp_talon_data.h"
+#include "src/gfx/deps/pack.h"
+#include "src/gfx/frames.h"
+
+// Indices of the ship's animation frames in its atlas, and in
+// USP_TALON_FRAMES. These must match the order in the Makefile.
+#define USP_TALON_FRAME_M 0
+#define USP_TALON_FRAME_L1 1
+#define USP_TALON_FRAME_L2 2
+#define USP_TALON_FRAME_R1 3
+#define USP_TALON_FRAME_R2 4
+#define USP_TALON_FRAME_N 5
 
 extern int RES_ID_USP_TALON;
+extern SPR_FRAME *USP_TALON_FRAMES[];
+int usp_talon_callback();
+void usp_talon_unload();
 void usp_talon_register();
 
 #endif
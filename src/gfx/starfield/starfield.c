@@ -11,6 +11,7 @@
 #include <stdbool.h>
 
 #include "src/gfx/modes.h"
+#include "src/gfx/palettes.h"
 #include "src/gfx/starfield/algos.h"
 #include "src/gfx/starfield/starfield.h"
 
@@ -280,3 +281,16 @@ RGB *get_starfield_palette() {
 
     return pal;
 }
+
+/**
+ * Makes the stars shimmer by cycling the hues of the starfield palette.
+ * Each hue moves on to the next set of shades, so every star changes
+ * color without a single pixel being redrawn.
+ * Returns the cycle's ID.
+ */
+int start_starfield_cycle(RGB *pal) {
+    return pal_cycle_add(
+        pal, SHADES_OFFSET, SHADES * LUM_N, LUM_N, STAR_CYCLE_MS,
+        PAL_CYCLE_FORWARD
+    );
+}
@@ -13,9 +13,12 @@
 // of counter ticks, then the next one begins.
 // Changing this will prevent some visualizations from working correctly.
 #define COUNTER_MAX 360
+// Milliseconds between steps of the starfield's hue cycle.
+#define STAR_CYCLE_MS 120
 
 int loop_starfield(BITMAP *buffer);
 int star_hue_color(int n);
+int start_starfield_cycle(RGB *pal);
 RGB *get_starfield_palette();
 void draw_star(BITMAP *buffer, int x, int y, int c);
 void draw_starfield(BITMAP *buffer);
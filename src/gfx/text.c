@@ -6,13 +6,12 @@
 #include <allegro.h>
 #include <stdio.h>
 
+#include "src/gfx/glyphs.h"
 #include "src/gfx/text.h"
-#include "src/gfx/deps/manager.h"
+#include "src/gfx/textcache.h"
 #include "src/gfx/res/flim.h"
 #include "src/gfx/res/tin.h"
 
-DATAFILE *font_data;
-
 /**
  * Adds the standard font colors to a palette. They're added to the
  * end of the palette, at positions 252-254 (255 being reserved for black).
@@ -42,6 +41,39 @@ void draw_textf(BITMAP *buffer, int x, int y, int color_a, int color_b,
     draw_text(buffer, x, y, color_a, color_b, bg, font, align, txt);
 }
 
+/**
+ * Sets the true text colors if color_a is one of the predefined colors,
+ * e.g. TXT_WHITE. Otherwise, the desired colors were passed directly
+ * and nothing changes.
+ * Note, all predefined colors have a value of less than zero.
+ */
+void text_colors(int *color_a, int *color_b) {
+    switch (*color_a) {
+        case TXT_WHITE:
+            *color_a = palette_color[254];
+            *color_b = palette_color[253];
+            break;
+        case TXT_GRAY:
+            *color_a = palette_color[253];
+            *color_b = palette_color[252];
+            break;
+    }
+}
+
+/**
+ * Returns the glyph set of one of our fonts (e.g. TXT_REGULAR),
+ * or NULL if it isn't loaded.
+ */
+TXT_GLYPHSET *text_glyphs(int font) {
+    switch (font) {
+        case TXT_REGULAR:
+            return FLIM_GLYPHS;
+        case TXT_SMALL:
+            return TIN_GLYPHS;
+    }
+    return NULL;
+}
+
 /**
  * Draws text onto a buffer using our standardized fonts and settings.
  *
@@ -50,53 +82,40 @@ void draw_textf(BITMAP *buffer, int x, int y, int color_a, int color_b,
  * and uses our custom fonts. Two colors can be passed, although
  * to get the standardized colors you should pass TXT_WHITE or another
  * label to color_a (in that event, color_b will be ignored).
+ *
+ * Both layers of our fonts are merged into one glyph set when the pack
+ * is built, so the text is drawn in a single pass.
  */
 void draw_text(BITMAP *buffer, int x, int y, int color_a, int color_b,
     int bg, int font, int align, char txt[TXT_MAX_SIZE])
 {
-    void (*txt_fn)() = 0;
+    TXT_GLYPHSET *set;
+    int w;
 
-    // Assign the text drawing function based on alignment.
-    switch (align) {
-        case TXT_LEFT:
-            txt_fn = textout_ex;
-            break;
-        case TXT_CENTER:
-            txt_fn = textout_centre_ex;
-            break;
-        case TXT_RIGHT:
-            txt_fn = textout_right_ex;
-            break;
+    text_colors(&color_a, &color_b);
+    set = text_glyphs(font);
+    if (!set) {
+        return;
     }
 
-    // Set text color; either the desired colors were passed directly,
-    // or color_a was set to e.g. TXT_WHITE. If it's the latter,
-    // set the true colors here.
-    // Note, all predefined colors have a value of less than zero.
-    if (color_a < 0) {
-        switch (color_a) {
-            case TXT_WHITE:
-                color_a = palette_color[254];
-                color_b = palette_color[253];
-                break;
-            case TXT_GRAY:
-                color_a = palette_color[253];
-                color_b = palette_color[252];
-                break;
-        }
+    // Most strings are drawn over and over again, so they're normally
+    // drawn from the text cache, as a single sprite.
+    if (text_cache_draw(buffer, x, y, set, color_a, color_b, bg, align,
+        txt)) {
+        return;
     }
 
-    // Finally, print the text using a custom setup for each font.
-    switch (font) {
-        case TXT_REGULAR:
-            font_data = dep_data_ref(RES_ID_FLIM);
-            txt_fn(buffer, font_data[FLIM_WHITE].dat, txt, x, y, color_a, bg);
-            txt_fn(buffer, font_data[FLIM_GRAY].dat, txt, x, y, color_b, bg);
+    w = glyphs_length(set, txt);
+    switch (align) {
+        case TXT_CENTER:
+            x -= w / 2;
             break;
-        case TXT_SMALL:
-            font_data = dep_data_ref(RES_ID_TIN);
-            txt_fn(buffer, font_data[TIN_WHITE].dat, txt, x, y, color_a, bg);
-            txt_fn(buffer, font_data[TIN_GRAY].dat, txt, x, y, color_b, bg);
+        case TXT_RIGHT:
+            x -= w;
             break;
     }
+    if (bg != -1) {
+        rectfill(buffer, x, y, x + w - 1, y + set->h - 1, bg);
+    }
+    draw_glyphs(buffer, set, txt, x, y, color_a, color_b);
 }
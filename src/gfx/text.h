@@ -16,10 +16,14 @@
 
 #define TXT_MAX_SIZE 512
 
+#include "src/gfx/glyphs.h"
+
+TXT_GLYPHSET *text_glyphs(int font);
 void add_text_colors(RGB *pal);
 void draw_textf(BITMAP *buffer, int x, int y, int color_a, int color_b,
     int bg, int font, int align, const char *format, ...);
 void draw_text(BITMAP *buffer, int x, int y, int color_a, int color_b,
     int bg, int font, int align, char txt[TXT_MAX_SIZE]);
+void text_colors(int *color_a, int *color_b);
 
 #endif
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "src/gfx/text.h"
+#include "src/gfx/textcache.h"
+
+// Rendered strings. Entries without a sprite are free.
+TXT_CACHE_ENTRY txt_cache[TXT_CACHE_SIZE];
+// Number of bytes of sprite data in the cache.
+long txt_cache_bytes = 0;
+// Incremented on every lookup; used to find the least recently used entry.
+unsigned long txt_cache_tick = 0;
+// Number of times a string was found in the cache, or had to be rendered.
+long txt_cache_hits = 0;
+long txt_cache_misses = 0;
+long txt_cache_evictions = 0;
+
+/**
+ * Returns a hash of a string, used to quickly skip non-matching entries.
+ */
+static unsigned long text_hash(char *txt) {
+    unsigned long hash = 5381;
+
+    while (*txt) {
+        hash = (hash * 33) ^ (unsigned char)*txt++;
+    }
+    return hash;
+}
+
+/**
+ * Returns how far to the left of x a string is drawn for a given alignment.
+ */
+static int align_offset(TXT_GLYPHSET *set, char *txt, int align) {
+    switch (align) {
+        case TXT_CENTER:
+            return glyphs_length(set, txt) / 2;
+        case TXT_RIGHT:
+            return glyphs_length(set, txt);
+    }
+    return 0;
+}
+
+/**
+ * Renders a string into an RLE sprite with a transparent background.
+ * ofs is set to the distance between the sprite's left edge and the
+ * text's x position. Returns NULL if the string is empty.
+ * Colors equal to MASK_COLOR_8 come out transparent.
+ */
+RLE_SPRITE *render_text(TXT_GLYPHSET *set, int color_a, int color_b,
+    int align, char *txt, int *ofs)
+{
+    BITMAP *bmp;
+    RLE_SPRITE *sprite;
+    int w = glyphs_length(set, txt);
+
+    *ofs = align_offset(set, txt, align);
+    if (w <= 0 || set->h <= 0) {
+        return NULL;
+    }
+
+    bmp = create_bitmap_ex(8, w, set->h);
+    if (!bmp) {
+        return NULL;
+    }
+    clear_to_color(bmp, MASK_COLOR_8);
+    draw_glyphs(bmp, set, txt, 0, 0, color_a, color_b);
+    sprite = get_rle_sprite(bmp);
+    destroy_bitmap(bmp);
+    return sprite;
+}
+
+/**
+ * Frees the sprite of an entry.
+ */
+static void text_cache_evict(TXT_CACHE_ENTRY *entry) {
+    txt_cache_bytes -= entry->sprite->size;
+    destroy_rle_sprite(entry->sprite);
+    entry->sprite = NULL;
+    txt_cache_evictions += 1;
+}
+
+/**
+ * Returns the least recently used entry, skipping free entries and keep.
+ * Returns NULL if there are no other entries.
+ */
+static TXT_CACHE_ENTRY *text_cache_lru(TXT_CACHE_ENTRY *keep) {
+    TXT_CACHE_ENTRY *entry = NULL;
+    int a;
+
+    for (a = 0; a < TXT_CACHE_SIZE; ++a) {
+        if (!txt_cache[a].sprite || &txt_cache[a] == keep) {
+            continue;
+        }
+        if (!entry || txt_cache[a].last_used < entry->last_used) {
+            entry = &txt_cache[a];
+        }
+    }
+    return entry;
+}
+
+/**
+ * Returns a free entry, evicting the least recently used one if needed.
+ */
+static TXT_CACHE_ENTRY *text_cache_slot() {
+    TXT_CACHE_ENTRY *entry;
+    int a;
+
+    for (a = 0; a < TXT_CACHE_SIZE; ++a) {
+        if (!txt_cache[a].sprite) {
+            return &txt_cache[a];
+        }
+    }
+    entry = text_cache_lru(NULL);
+    text_cache_evict(entry);
+    return entry;
+}
+
+/**
+ * Draws a cached string, filling in its background first if it has one.
+ */
+static void text_cache_blit(BITMAP *buffer, TXT_CACHE_ENTRY *entry, int x,
+    int y, int bg)
+{
+    x -= entry->ofs;
+    if (bg != -1) {
+        rectfill(
+            buffer, x, y, x + entry->sprite->w - 1,
+            y + entry->sprite->h - 1, bg
+        );
+    }
+    draw_rle_sprite(buffer, entry->sprite, x, y);
+}
+
+/**
+ * Draws a string from the cache, rendering and caching it first if it
+ * isn't in there yet. The same entry is used for any background color.
+ *
+ * Returns false if the string can't be cached, e.g. because it's too long,
+ * in which case nothing is drawn. Text in the mask color can't be cached
+ * either, since it would be transparent in the sprite.
+ */
+bool text_cache_draw(BITMAP *buffer, int x, int y, TXT_GLYPHSET *set,
+    int color_a, int color_b, int bg, int align, char *txt)
+{
+    TXT_CACHE_ENTRY *entry;
+    RLE_SPRITE *sprite;
+    unsigned long hash;
+    int a, ofs;
+
+    if (strlen(txt) >= TXT_CACHE_KEY_LEN || color_a == MASK_COLOR_8 ||
+        color_b == MASK_COLOR_8) {
+        return false;
+    }
+    hash = text_hash(txt);
+    txt_cache_tick += 1;
+
+    for (a = 0; a < TXT_CACHE_SIZE; ++a) {
+        entry = &txt_cache[a];
+        if (entry->sprite && entry->hash == hash &&
+            entry->set == set &&
+            entry->color_a == color_a && entry->color_b == color_b &&
+            entry->align == align &&
+            strcmp(entry->txt, txt) == 0) {
+            entry->last_used = txt_cache_tick;
+            txt_cache_hits += 1;
+            text_cache_blit(buffer, entry, x, y, bg);
+            return true;
+        }
+    }
+
+    // Not in the cache; render it and make room for it. Nothing is
+    // evicted if there's nothing to store, e.g. for an empty string.
+    txt_cache_misses += 1;
+    sprite = render_text(set, color_a, color_b, align, txt, &ofs);
+    if (!sprite) {
+        return false;
+    }
+    entry = text_cache_slot();
+    entry->sprite = sprite;
+    entry->ofs = ofs;
+    strcpy(entry->txt, txt);
+    entry->hash = hash;
+    entry->set = set;
+    entry->color_a = color_a;
+    entry->color_b = color_b;
+    entry->align = align;
+    entry->last_used = txt_cache_tick;
+    txt_cache_bytes += entry->sprite->size;
+    while (txt_cache_bytes > TXT_CACHE_BUDGET && text_cache_lru(entry)) {
+        text_cache_evict(text_cache_lru(entry));
+    }
+    text_cache_blit(buffer, entry, x, y, bg);
+    return true;
+}
+
+/**
+ * Frees all rendered strings. Needed if a glyph set is replaced, since
+ * a new one could end up at the same address.
+ */
+void text_cache_flush() {
+    int a;
+
+    for (a = 0; a < TXT_CACHE_SIZE; ++a) {
+        if (txt_cache[a].sprite) {
+            destroy_rle_sprite(txt_cache[a].sprite);
+            txt_cache[a].sprite = NULL;
+        }
+    }
+    txt_cache_bytes = 0;
+}
+
+/**
+ * Prints the cache's hit rate for debugging.
+ */
+void debug_text_cache(FILE *out) {
+    long total = txt_cache_hits + txt_cache_misses;
+
+    fprintf(
+        out,
+        "Text cache: hits=%ld misses=%ld (%ld%%) evictions=%ld bytes=%ld\n",
+        txt_cache_hits,
+        txt_cache_misses,
+        total > 0 ? (txt_cache_hits * 100) / total : 0,
+        txt_cache_evictions,
+        txt_cache_bytes
+    );
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "src/gfx/glyphs.h"
+
+#ifndef __CEEGEE_GFX_TEXTCACHE__
+#define __CEEGEE_GFX_TEXTCACHE__
+
+// Number of rendered strings that are kept in the cache.
+#define TXT_CACHE_SIZE 32
+// Strings this long or longer aren't cached.
+#define TXT_CACHE_KEY_LEN 64
+// Maximum number of bytes of sprite data kept in the cache.
+#define TXT_CACHE_BUDGET 32768
+
+// A rendered string, drawn with a glyph set.
+// The sprite is drawn at x - ofs, which takes care of the alignment.
+// Its background is always transparent: an opaque one is filled in
+// separately, since a background of color 0 would be indistinguishable
+// from the sprite's mask color.
+// last_used is used to find the least recently used entry.
+typedef struct TXT_CACHE_ENTRY {
+    char txt[TXT_CACHE_KEY_LEN];
+    unsigned long hash;
+    TXT_GLYPHSET *set;
+    int color_a, color_b, align;
+    int ofs;
+    RLE_SPRITE *sprite;
+    unsigned long last_used;
+} TXT_CACHE_ENTRY;
+
+bool text_cache_draw(BITMAP *buffer, int x, int y, TXT_GLYPHSET *set,
+    int color_a, int color_b, int bg, int align, char *txt);
+static TXT_CACHE_ENTRY *text_cache_lru(TXT_CACHE_ENTRY *keep);
+static TXT_CACHE_ENTRY *text_cache_slot();
+static void text_cache_blit(BITMAP *buffer, TXT_CACHE_ENTRY *entry, int x,
+    int y, int bg);
+static int align_offset(TXT_GLYPHSET *set, char *txt, int align);
+static void text_cache_evict(TXT_CACHE_ENTRY *entry);
+static unsigned long text_hash(char *txt);
+RLE_SPRITE *render_text(TXT_GLYPHSET *set, int color_a, int color_b,
+    int align, char *txt, int *ofs);
+void debug_text_cache(FILE *out);
+void text_cache_flush();
+
+#endif
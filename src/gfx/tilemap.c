@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "src/gfx/tilemap.h"
+
+/**
+ * Creates a tilemap of cols by rows tiles, all set to tile 0, using the
+ * tiles of a tileset. The tileset belongs to the caller. view_w and
+ * view_h are the size of the area the map is drawn to.
+ * Returns NULL if there isn't enough memory.
+ */
+TILEMAP *tilemap_create(int cols, int rows, BITMAP *tileset, int view_w,
+    int view_h)
+{
+    TILEMAP *map = malloc(sizeof(TILEMAP));
+
+    if (!map) {
+        return NULL;
+    }
+    map->cols = MAX(1, cols);
+    map->rows = MAX(1, rows);
+    map->tileset = tileset;
+    map->tileset_cols = MAX(1, tileset->w >> TILE_BITS);
+    map->view_w = view_w;
+    map->view_h = view_h;
+    map->x = 0;
+    map->y = 0;
+    map->buf_cols = (view_w + TILE_SIZE - 1) / TILE_SIZE + 1;
+    map->buf_rows = (view_h + TILE_SIZE - 1) / TILE_SIZE + 1;
+    map->buf_x = 0;
+    map->buf_y = 0;
+    map->buf_valid = false;
+    map->tiles = calloc(map->cols * map->rows, sizeof(unsigned char));
+    map->buf = create_bitmap_ex(
+        bitmap_color_depth(tileset),
+        map->buf_cols * TILE_SIZE,
+        map->buf_rows * TILE_SIZE
+    );
+    if (!map->tiles || !map->buf) {
+        tilemap_destroy(map);
+        return NULL;
+    }
+    return map;
+}
+
+/**
+ * Frees a tilemap, but not its tileset.
+ */
+void tilemap_destroy(TILEMAP *map) {
+    if (!map) {
+        return;
+    }
+    if (map->buf) {
+        destroy_bitmap(map->buf);
+    }
+    free(map->tiles);
+    free(map);
+}
+
+/**
+ * Returns a modulo n, where the result is never negative.
+ */
+static int tilemap_mod(int a, int n) {
+    a %= n;
+    return a < 0 ? a + n : a;
+}
+
+/**
+ * Sets the tile at column c and row r of the map. If the tile is in view,
+ * it's redrawn right away. If the map is smaller than the buffer, the tile
+ * can be in it more than once, so the whole buffer is redrawn instead.
+ */
+void tilemap_set(TILEMAP *map, int c, int r, int tile) {
+    c = tilemap_mod(c, map->cols);
+    r = tilemap_mod(r, map->rows);
+    map->tiles[r * map->cols + c] = tile;
+    if (map->buf_valid && map->cols >= map->buf_cols &&
+        map->rows >= map->buf_rows) {
+        // Find the copy of the tile that's in the buffer, if any.
+        c = map->buf_x + tilemap_mod(c - map->buf_x, map->cols);
+        r = map->buf_y + tilemap_mod(r - map->buf_y, map->rows);
+        if (c < map->buf_x + map->buf_cols && r < map->buf_y + map->buf_rows) {
+            tilemap_draw_tile(map, c, r);
+        }
+    }
+    else {
+        map->buf_valid = false;
+    }
+}
+
+/**
+ * Makes the next call to tilemap_draw() redraw every visible tile,
+ * e.g. after the tileset has changed.
+ */
+void tilemap_invalidate(TILEMAP *map) {
+    map->buf_valid = false;
+}
+
+/**
+ * Moves the view to a position on the map, in pixels. The map repeats,
+ * so any position is valid.
+ */
+void tilemap_scroll_to(TILEMAP *map, int x, int y) {
+    map->x = x;
+    map->y = y;
+}
+
+/**
+ * Draws the tile at column c and row r of the map into the buffer.
+ */
+static void tilemap_draw_tile(TILEMAP *map, int c, int r) {
+    int tile = map->tiles[
+        tilemap_mod(r, map->rows) * map->cols + tilemap_mod(c, map->cols)
+    ];
+
+    blit(
+        map->tileset,
+        map->buf,
+        (tile % map->tileset_cols) << TILE_BITS,
+        (tile / map->tileset_cols) << TILE_BITS,
+        tilemap_mod(c, map->buf_cols) << TILE_BITS,
+        tilemap_mod(r, map->buf_rows) << TILE_BITS,
+        TILE_SIZE,
+        TILE_SIZE
+    );
+}
+
+/**
+ * Draws the tiles from column c1 and row r1 up to, but not including,
+ * column c2 and row r2 into the buffer.
+ */
+static void tilemap_draw_tiles(TILEMAP *map, int c1, int r1, int c2, int r2) {
+    int c, r;
+
+    for (r = r1; r < r2; ++r) {
+        for (c = c1; c < c2; ++c) {
+            tilemap_draw_tile(map, c, r);
+        }
+    }
+}
+
+/**
+ * Brings the buffer up to date with the view's position. Tiles that were
+ * already in the buffer stay where they are, so normally only a row or
+ * column of tiles is drawn: first the rows that came into view, across the
+ * whole width of the buffer, and then the columns that came into view,
+ * for the rows that were already there. If the view moved further than
+ * the size of the buffer, every tile is drawn.
+ */
+static void tilemap_refresh(TILEMAP *map) {
+    // Shifting rounds down, also for negative positions.
+    int c = map->x >> TILE_BITS, r = map->y >> TILE_BITS;
+    int bc = map->buf_x, br = map->buf_y;
+    int cols = map->buf_cols, rows = map->buf_rows;
+    int r1, r2;
+
+    if (!map->buf_valid || ABS(c - bc) >= cols || ABS(r - br) >= rows) {
+        tilemap_draw_tiles(map, c, r, c + cols, r + rows);
+    }
+    else {
+        if (r > br) {
+            tilemap_draw_tiles(map, c, br + rows, c + cols, r + rows);
+        }
+        else if (r < br) {
+            tilemap_draw_tiles(map, c, r, c + cols, br);
+        }
+        r1 = MAX(r, br);
+        r2 = MIN(r, br) + rows;
+        if (c > bc) {
+            tilemap_draw_tiles(map, bc + cols, r1, c + cols, r2);
+        }
+        else if (c < bc) {
+            tilemap_draw_tiles(map, c, r1, bc, r2);
+        }
+    }
+    map->buf_x = c;
+    map->buf_y = r;
+    map->buf_valid = true;
+}
+
+/**
+ * Draws the view onto a buffer, with its top left corner at x, y.
+ * Since the tiles wrap around inside the map's own buffer, the view is
+ * split into up to four parts where it crosses the buffer's right and
+ * bottom edges. If the view only scrolls vertically and stays within the
+ * first column of tiles, as in the flying handler, that's two blits.
+ */
+void tilemap_draw(TILEMAP *map, BITMAP *buffer, int x, int y) {
+    int sx = tilemap_mod(map->x, map->buf->w);
+    int sy = tilemap_mod(map->y, map->buf->h);
+    int w1 = MIN(map->view_w, map->buf->w - sx);
+    int h1 = MIN(map->view_h, map->buf->h - sy);
+    int w2 = map->view_w - w1, h2 = map->view_h - h1;
+
+    tilemap_refresh(map);
+
+    blit(map->buf, buffer, sx, sy, x, y, w1, h1);
+    if (w2 > 0) {
+        blit(map->buf, buffer, 0, sy, x + w1, y, w2, h1);
+    }
+    if (h2 > 0) {
+        blit(map->buf, buffer, sx, 0, x, y + h1, w1, h2);
+    }
+    if (w2 > 0 && h2 > 0) {
+        blit(map->buf, buffer, 0, 0, x + w1, y + h1, w2, h2);
+    }
+}
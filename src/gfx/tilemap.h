@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GFX_TILEMAP__
+#define __CEEGEE_GFX_TILEMAP__
+
+// Tiles are squares of 16x16 pixels.
+#define TILE_BITS 4
+#define TILE_SIZE (1 << TILE_BITS)
+
+// Scrolling tile background. The map is cols by rows tiles, and repeats
+// in both directions. Tile n is the nth tile of the tileset, counting
+// from left to right and then from top to bottom.
+//
+// The visible part of the map is kept in buf, which is one tile larger
+// than the view in both directions and wraps around: the tile at column c
+// and row r is always drawn at column c % buf_cols and row r % buf_rows.
+// The buffer holds the tiles from buf_x, buf_y onward; when the map
+// scrolls, only the tiles that come into view are drawn.
+// x and y are the position of the view in pixels, and may be negative.
+typedef struct TILEMAP {
+    int cols, rows;
+    unsigned char *tiles;
+    BITMAP *tileset;
+    int tileset_cols;
+    BITMAP *buf;
+    int buf_cols, buf_rows;
+    int buf_x, buf_y;
+    bool buf_valid;
+    int view_w, view_h;
+    int x, y;
+} TILEMAP;
+
+TILEMAP *tilemap_create(int cols, int rows, BITMAP *tileset, int view_w,
+    int view_h);
+static int tilemap_mod(int a, int n);
+static void tilemap_draw_tile(TILEMAP *map, int c, int r);
+static void tilemap_draw_tiles(TILEMAP *map, int c1, int r1, int c2, int r2);
+static void tilemap_refresh(TILEMAP *map);
+void tilemap_destroy(TILEMAP *map);
+void tilemap_draw(TILEMAP *map, BITMAP *buffer, int x, int y);
+void tilemap_invalidate(TILEMAP *map);
+void tilemap_scroll_to(TILEMAP *map, int x, int y);
+void tilemap_set(TILEMAP *map, int c, int r, int tile);
+
+#endif
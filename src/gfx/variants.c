@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "src/gfx/batch.h"
+#include "src/gfx/frames.h"
+#include "src/gfx/masks.h"
+#include "src/gfx/variants.h"
+
+/**
+ * Creates a cache of rotated and scaled versions of a sprite. Rotating and
+ * scaling a sprite every frame is far too slow in 8-bit modes, so instead
+ * the nearest version is picked from the cache when the sprite is drawn.
+ * Should be called from a resource's callback, like frame_create().
+ * If lazy is false, the variants are all made here, as far as the memory
+ * budget allows; otherwise they're made when they're first used.
+ * Returns NULL if there isn't enough memory.
+ */
+SPR_VARIANTS *variants_create(RLE_SPRITE *src, int angles, int scales,
+    fixed scale_min, fixed scale_max, long budget, bool lazy)
+{
+    SPR_VARIANTS *v = malloc(sizeof(SPR_VARIANTS));
+
+    if (!v) {
+        return NULL;
+    }
+    v->src = src;
+    v->angles = MID(1, angles, VARIANTS_ANGLES_MAX);
+    v->scales = MID(1, scales, VARIANTS_SCALES_MAX);
+    v->scale_min = scale_min;
+    v->scale_max = MAX(scale_min, scale_max);
+    v->budget = budget;
+    v->used = 0;
+    v->count = 0;
+    v->lazy = lazy;
+    v->full = false;
+    v->frames = calloc(v->angles * v->scales, sizeof(SPR_FRAME *));
+    v->src_bmp = create_bitmap_ex(src->color_depth, src->w, src->h);
+    if (!v->frames || !v->src_bmp) {
+        variants_destroy(v);
+        return NULL;
+    }
+    // Rotating needs a bitmap, so the sprite is drawn into one once.
+    clear_to_color(v->src_bmp, bitmap_mask_color(v->src_bmp));
+    draw_rle_sprite(v->src_bmp, src, 0, 0);
+
+    if (!lazy) {
+        variants_make_all(v);
+    }
+    return v;
+}
+
+/**
+ * Frees a variant cache and all of its variants, but not its sprite.
+ */
+void variants_destroy(SPR_VARIANTS *v) {
+    RLE_SPRITE *rle;
+    int a;
+
+    if (!v) {
+        return;
+    }
+    if (v->frames) {
+        for (a = 0; a < v->angles * v->scales; ++a) {
+            if (!v->frames[a]) {
+                continue;
+            }
+            rle = v->frames[a]->rle;
+            frame_destroy(v->frames[a]);
+            destroy_rle_sprite(rle);
+        }
+        free(v->frames);
+    }
+    if (v->src_bmp) {
+        destroy_bitmap(v->src_bmp);
+    }
+    free(v);
+}
+
+/**
+ * Returns the number of bytes taken by a variant: its RLE sprite,
+ * collision mask and compiled sprite.
+ */
+static long variants_size(SPR_FRAME *frame) {
+    long size = sizeof(SPR_FRAME) + sizeof(RLE_SPRITE) + frame->rle->size;
+    int a;
+
+    size += sizeof(COL_MASK) +
+        (long)frame->mask->h * frame->mask->words * sizeof(unsigned long);
+    if (frame->cspr) {
+        size += sizeof(COMPILED_SPRITE);
+        for (a = 0; a < 4; ++a) {
+            if (frame->cspr->proc[a].draw) {
+                size += frame->cspr->proc[a].len;
+            }
+        }
+    }
+    return size;
+}
+
+/**
+ * Makes a single variant. The variant's frame is a square that fits the
+ * sprite at any angle, so that the sprite's center stays in the same spot.
+ * Returns NULL and stops any more variants from being made if the variant
+ * doesn't fit in the budget, or if there isn't enough memory.
+ */
+static SPR_FRAME *variants_make(SPR_VARIANTS *v, int angle, int scale) {
+    RLE_SPRITE *src = v->src, *rle;
+    SPR_FRAME *frame;
+    BITMAP *bmp;
+    fixed a, s = v->scale_min;
+    long size;
+    int d;
+
+    // Angle steps go up to 256, so this can't overflow.
+    a = ((angle << 16) / v->angles) << 8;
+    if (v->scales > 1) {
+        s += ((v->scale_max - v->scale_min) / (v->scales - 1)) * scale;
+    }
+    d = MAX(1, fixceil(fixmul(fixhypot(itofix(src->w), itofix(src->h)), s)));
+
+    bmp = create_bitmap_ex(src->color_depth, d, d);
+    if (!bmp) {
+        v->full = true;
+        return NULL;
+    }
+    clear_to_color(bmp, bitmap_mask_color(bmp));
+    pivot_scaled_sprite(
+        bmp, v->src_bmp, d / 2, d / 2, src->w / 2, src->h / 2, a, s
+    );
+    rle = get_rle_sprite(bmp);
+    destroy_bitmap(bmp);
+    frame = rle ? frame_create(rle) : NULL;
+    if (!frame) {
+        if (rle) {
+            destroy_rle_sprite(rle);
+        }
+        v->full = true;
+        return NULL;
+    }
+
+    size = variants_size(frame);
+    if (v->used + size > v->budget) {
+        frame_destroy(frame);
+        destroy_rle_sprite(rle);
+        v->full = true;
+        return NULL;
+    }
+    v->used += size;
+    v->count += 1;
+    return frame;
+}
+
+/**
+ * Makes every variant that hasn't been made yet, until the budget runs out.
+ * The unrotated variant of every scale level is made first, so that each
+ * level has something to fall back on if the budget is too small.
+ */
+void variants_make_all(SPR_VARIANTS *v) {
+    SPR_FRAME **frames;
+    int a, s;
+
+    for (a = 0; a < v->angles; ++a) {
+        for (s = 0; s < v->scales && !v->full; ++s) {
+            frames = v->frames + s * v->angles;
+            if (!frames[a]) {
+                frames[a] = variants_make(v, a, s);
+            }
+        }
+    }
+}
+
+/**
+ * Returns the variant nearest to an angle and scale. If that variant
+ * hasn't been made, it's made now if the cache is lazy; if it can't be,
+ * the nearest angle of the same scale level is used instead.
+ * Returns NULL if there's no variant of that scale level at all.
+ */
+SPR_FRAME *variants_get(SPR_VARIANTS *v, fixed angle, fixed scale) {
+    SPR_FRAME **frames;
+    fixed step;
+    int a, s = 0, d, n = v->angles;
+
+    // The angle is reduced to a full circle of 16 bits, so this
+    // can't overflow either.
+    a = ((((angle & 0xFFFFFF) >> 8) * n + 0x8000) >> 16) % n;
+    if (v->scales > 1 && scale > v->scale_min) {
+        step = (v->scale_max - v->scale_min) / (v->scales - 1);
+        s = step > 0 ? (fixdiv(scale - v->scale_min, step) + 0x8000) >> 16 : 0;
+        s = MIN(s, v->scales - 1);
+    }
+
+    frames = v->frames + s * n;
+    if (!frames[a] && v->lazy && !v->full) {
+        frames[a] = variants_make(v, a, s);
+    }
+    if (frames[a]) {
+        return frames[a];
+    }
+    for (d = 1; d <= n / 2; ++d) {
+        if (frames[(a + d) % n]) {
+            return frames[(a + d) % n];
+        }
+        if (frames[(a + n - d) % n]) {
+            return frames[(a + n - d) % n];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Submits the variant nearest to an angle and scale to the sprite batch,
+ * centered on x, y.
+ */
+void variants_draw(SPR_VARIANTS *v, int x, int y, fixed angle, fixed scale,
+    int layer)
+{
+    SPR_FRAME *frame = variants_get(v, angle, scale);
+
+    if (!frame) {
+        return;
+    }
+    batch_add(frame, x - frame->w / 2, y - frame->h / 2, layer);
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GFX_VARIANTS__
+#define __CEEGEE_GFX_VARIANTS__
+
+#include "src/gfx/frames.h"
+
+// Largest number of rotation steps and scale levels of a sprite.
+#define VARIANTS_ANGLES_MAX 256
+#define VARIANTS_SCALES_MAX 16
+
+// Pre-rotated and pre-scaled versions of a sprite. There are a number of
+// rotation steps spread evenly over a full circle, for each of a number
+// of scale levels spread evenly from scale_min to scale_max.
+// Angles use Allegro's convention: 256 units per circle, clockwise.
+// Each variant is a square frame centered on the sprite's center, stored
+// at frames[scale * angles + angle], or NULL if it hasn't been made yet.
+// Variants are made when the cache is created, or on first use if lazy
+// is set. used is the number of bytes taken by the variants; once making
+// one would take more than budget, no more are made.
+typedef struct SPR_VARIANTS {
+    RLE_SPRITE *src;
+    BITMAP *src_bmp;
+    int angles, scales;
+    fixed scale_min, scale_max;
+    SPR_FRAME **frames;
+    long budget, used;
+    int count;
+    bool lazy;
+    bool full;
+} SPR_VARIANTS;
+
+SPR_FRAME *variants_get(SPR_VARIANTS *v, fixed angle, fixed scale);
+SPR_VARIANTS *variants_create(RLE_SPRITE *src, int angles, int scales,
+    fixed scale_min, fixed scale_max, long budget, bool lazy);
+static SPR_FRAME *variants_make(SPR_VARIANTS *v, int angle, int scale);
+static long variants_size(SPR_FRAME *frame);
+void variants_destroy(SPR_VARIANTS *v);
+void variants_draw(SPR_VARIANTS *v, int x, int y, fixed angle, fixed scale,
+    int layer);
+void variants_make_all(SPR_VARIANTS *v);
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "src/gfx/text.h"
+#include "src/gfx/textcache.h"
+#include "src/gfx/widgets.h"
+
+/**
+ * Initializes a text widget. Colors, font and alignment are the same
+ * as for draw_text(). The widget has no values bound to it yet.
+ */
+void widget_init(TXT_WIDGET *widget, int x, int y, int color_a, int color_b,
+    int font, int align, void (*format)(char txt[TXT_MAX_SIZE]))
+{
+    widget->x = x;
+    widget->y = y;
+    widget->color_a = color_a;
+    widget->color_b = color_b;
+    widget->font = font;
+    widget->align = align;
+    widget->format = format;
+    widget->value_n = 0;
+    widget->snap_size = 0;
+    widget->valid = false;
+    widget->sprite = NULL;
+    widget->ofs = 0;
+}
+
+/**
+ * Binds a value to a widget. Whenever the value changes,
+ * the widget's text is formatted again.
+ */
+void widget_bind(TXT_WIDGET *widget, volatile void *value, int size) {
+    if (widget->value_n == TXT_WIDGET_VALUES ||
+        widget->snap_size + size > TXT_WIDGET_SNAP) {
+        return;
+    }
+    widget->values[widget->value_n] = value;
+    widget->sizes[widget->value_n] = size;
+    widget->value_n += 1;
+    widget->snap_size += size;
+    widget->valid = false;
+}
+
+/**
+ * Checks whether any of the bound values have changed since the widget
+ * was last rendered, and stores their current values if so.
+ */
+static bool widget_changed(TXT_WIDGET *widget) {
+    unsigned char snap[TXT_WIDGET_SNAP];
+    int a, n = 0;
+
+    for (a = 0; a < widget->value_n; ++a) {
+        memcpy(snap + n, (void *)widget->values[a], widget->sizes[a]);
+        n += widget->sizes[a];
+    }
+    if (widget->valid && memcmp(snap, widget->snap, n) == 0) {
+        return false;
+    }
+    memcpy(widget->snap, snap, n);
+    return true;
+}
+
+/**
+ * Formats the widget's text and renders it into a sprite.
+ */
+static void widget_render(TXT_WIDGET *widget) {
+    char txt[TXT_MAX_SIZE];
+    TXT_GLYPHSET *set = text_glyphs(widget->font);
+    int color_a = widget->color_a;
+    int color_b = widget->color_b;
+
+    if (widget->sprite) {
+        destroy_rle_sprite(widget->sprite);
+        widget->sprite = NULL;
+    }
+    if (!set) {
+        return;
+    }
+    text_colors(&color_a, &color_b);
+    widget->format(txt);
+    widget->sprite = render_text(
+        set, color_a, color_b, widget->align, txt, &widget->ofs
+    );
+    widget->valid = true;
+}
+
+/**
+ * Draws a widget. Its text is only formatted, measured and rendered when
+ * one of its bound values has changed; otherwise the previously rendered
+ * image is drawn.
+ */
+void widget_draw(TXT_WIDGET *widget, BITMAP *buffer) {
+    if (widget_changed(widget)) {
+        widget_render(widget);
+    }
+    if (widget->sprite) {
+        draw_rle_sprite(
+            buffer, widget->sprite, widget->x - widget->ofs, widget->y
+        );
+    }
+}
+
+/**
+ * Frees a widget's rendered image.
+ */
+void widget_destroy(TXT_WIDGET *widget) {
+    if (widget->sprite) {
+        destroy_rle_sprite(widget->sprite);
+        widget->sprite = NULL;
+    }
+    widget->valid = false;
+}
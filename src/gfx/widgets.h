@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdbool.h>
+
+#ifndef __CEEGEE_GFX_WIDGETS__
+#define __CEEGEE_GFX_WIDGETS__
+
+#include "src/gfx/text.h"
+
+// Maximum number of values a widget can be bound to.
+#define TXT_WIDGET_VALUES 6
+// Number of bytes available to store the values a widget was drawn with.
+#define TXT_WIDGET_SNAP 32
+
+// Retained text widget. It's bound to a number of values, and its text
+// is only formatted and rendered again when one of them changes.
+// The format function writes the widget's text; it's called with
+// the values as they are at that point. The text is rendered into a
+// sprite, so its colors mustn't resolve to the mask color (index 0).
+typedef struct TXT_WIDGET {
+    int x, y, color_a, color_b, font, align;
+    void (*format)(char txt[TXT_MAX_SIZE]);
+    volatile void *values[TXT_WIDGET_VALUES];
+    int sizes[TXT_WIDGET_VALUES];
+    int value_n;
+    unsigned char snap[TXT_WIDGET_SNAP];
+    int snap_size;
+    bool valid;
+    RLE_SPRITE *sprite;
+    int ofs;
+} TXT_WIDGET;
+
+static bool widget_changed(TXT_WIDGET *widget);
+static void widget_render(TXT_WIDGET *widget);
+void widget_bind(TXT_WIDGET *widget, volatile void *value, int size);
+void widget_destroy(TXT_WIDGET *widget);
+void widget_draw(TXT_WIDGET *widget, BITMAP *buffer);
+void widget_init(TXT_WIDGET *widget, int x, int y, int color_a, int color_b,
+    int font, int align, void (*format)(char txt[TXT_MAX_SIZE]));
+
+#endif
@@ -30,12 +30,11 @@ int main(int argc, char **argv) {
             print_sysinfo();
             return write_sysinfo_fb();
         case ARG_JUKEBOX:
-            start_jukebox();
-            return 0;
+            return start_jukebox();
+        case ARG_BENCH:
+            return start_bench();
     }
 
     // Run the main game code.
-    start_game();
-
-    return 0;
+    return start_game();
 }
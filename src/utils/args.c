@@ -4,13 +4,19 @@
  */
 
 #include <assert.h>
+#include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #include "src/utils/args.h"
 #include "src/utils/version.h"
 
+// Budget of the resident resource pool in kilobytes, if it was given
+// on the command line with /p. Otherwise, the default budget is used.
+long arg_pool_kb = ARG_POOL_DEFAULT;
+
 /**
  * Prints the program's usage information, MS-DOS style.
  */
@@ -23,6 +29,8 @@ void print_usage(char *name) {
     printf("  /v        Display version.\r\n");
     printf("  /b        Write build information for debugging.\r\n");
     printf("  /j        Play a song from the jukebox.\r\n");
+    printf("  /t        Run benchmarks and write them to bench.txt.\r\n");
+    printf("  /p<n>     Keep up to n KB of unused resources in memory.\r\n");
     printf("\r\n");
     printf("More information: %s\r\n", get_url());
 }
@@ -31,30 +39,42 @@ void print_usage(char *name) {
  * Parses command-line arguments and returns one of the ARG_* macros.
  * MS-DOS style slash arguments are accepted. We're not using getopt()
  * because it only seems to support dash arguments.
+ * Options that aren't commands, like /p, are stored in arg_* variables.
+ * They may come before or after the command. If more than one command
+ * is given, the first one is used.
  */
 int parse_args(int argc, char **argv) {
-    if (argc <= 1) {
-        return ARG_NOTHING;
-    }
+    int cmd = ARG_NOTHING, arg;
 
     // Skip over the program name.
     for (int a = 1; a < argc; ++a) {
+        arg = ARG_NOTHING;
         if (strcmp(argv[a], "/?") == 0) {
-            return ARG_USAGE;
+            arg = ARG_USAGE;
         }
         if (strcmp(argv[a], "/h") == 0 || strcmp(argv[a], "/H") == 0) {
-            return ARG_USAGE;
+            arg = ARG_USAGE;
         }
         if (strcmp(argv[a], "/v") == 0 || strcmp(argv[a], "/V") == 0) {
-            return ARG_VERSION;
+            arg = ARG_VERSION;
         }
         if (strcmp(argv[a], "/b") == 0 || strcmp(argv[a], "/B") == 0) {
-            return ARG_SYSINFO;
+            arg = ARG_SYSINFO;
         }
         if (strcmp(argv[a], "/j") == 0 || strcmp(argv[a], "/J") == 0) {
-            return ARG_JUKEBOX;
+            arg = ARG_JUKEBOX;
+        }
+        if (strcmp(argv[a], "/t") == 0 || strcmp(argv[a], "/T") == 0) {
+            arg = ARG_BENCH;
+        }
+        if ((strncmp(argv[a], "/p", 2) == 0 || strncmp(argv[a], "/P", 2) == 0)
+            && isdigit((unsigned char)argv[a][2])) {
+            arg_pool_kb = atol(argv[a] + 2);
+        }
+        if (cmd == ARG_NOTHING) {
+            cmd = arg;
         }
     }
 
-    return ARG_NOTHING;
+    return cmd;
 }
@@ -11,6 +11,11 @@
 #define ARG_JUKEBOX 3
 #define ARG_USAGE 4
 #define ARG_SYSINFO 5
+#define ARG_BENCH 6
+// Value of arg_pool_kb if no pool budget was given.
+#define ARG_POOL_DEFAULT -1
+
+extern long arg_pool_kb;
 
 int parse_args(int argc, char **argv);
 void print_usage();
@@ -0,0 +1,565 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/game/entities/grid.h"
+#include "src/game/entities/particles.h"
+#include "src/game/entities/pool.h"
+#include "src/gfx/deps/manager.h"
+#include "src/gfx/batch.h"
+#include "src/gfx/deps/pack.h"
+#include "src/gfx/frames.h"
+#include "src/gfx/glyphs.h"
+#include "src/gfx/modes.h"
+#include "src/gfx/res/flim.h"
+#include "src/gfx/variants.h"
+#include "src/utils/bench.h"
+#include "src/utils/counters.h"
+
+// String drawn by the text benchmark.
+char BENCH_TEXT[] = "Use arrow keys to choose another song";
+
+/**
+ * Returns the number of milliseconds since a clock() value.
+ */
+static long bench_ms(clock_t start) {
+    return ((clock() - start) * 1000) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Returns how many times something happened per second.
+ */
+static long bench_rate(long n, long ms) {
+    return ms > 0 ? (long)((n * 1000.0) / ms) : 0;
+}
+
+/**
+ * Measures how fast every object in the resource pack loads, which is
+ * mostly decompression (and conversion) time. Throughput is given in
+ * kilobytes of loaded data per second.
+ */
+void bench_pack(FILE *out) {
+    DATAFILE *item;
+    const char *name;
+    clock_t start;
+    long ms, bytes;
+    int a, b;
+
+    fprintf(out, "Pack objects (%d loads each):\n\n", BENCH_PACK_REPS);
+    fprintf(out, "object               type     bytes       ms     KB/s\n");
+    for (a = 0; a < pack_count(); ++a) {
+        // Load the object once outside of the timing to get its size,
+        // and to make sure it's in the disk cache.
+        if (!pack_load_obj(a)) {
+            continue;
+        }
+        item = &pack_ref()[a];
+        bytes = pack_obj_mem(a);
+        name = get_datafile_property(item, DAT_NAME);
+
+        start = clock();
+        for (b = 0; b < BENCH_PACK_REPS; ++b) {
+            unload_datafile_object(
+                load_datafile_object_indexed(pack_index, a)
+            );
+        }
+        ms = bench_ms(start);
+
+        fprintf(
+            out,
+            "%-20s %c%c%c%c %9ld %8ld %8ld\n",
+            name,
+            (item->type >> 24) & 0xFF,
+            (item->type >> 16) & 0xFF,
+            (item->type >> 8) & 0xFF,
+            item->type & 0xFF,
+            bytes,
+            ms,
+            ms > 0 ? (bytes * BENCH_PACK_REPS) / ms : 0
+        );
+        pack_unload_obj(a);
+    }
+}
+
+/**
+ * Releases everything the text benchmark loaded.
+ */
+static void bench_text_forget(int req) {
+    dep_forget(RES_ID_FLIM, req);
+    dep_forget_obj(FLIM_WHITE, req);
+    dep_forget_obj(FLIM_GRAY, req);
+}
+
+/**
+ * Compares drawing text with textout_ex(), which needs one call per font
+ * layer, to drawing it with the merged glyph set. Both draw into an 8-bit
+ * memory bitmap. Throughput is given in glyphs per second.
+ *
+ * The game only uses the glyph set. The two layers are still in the pack
+ * as regular fonts so that they can be compared here.
+ */
+void bench_text(FILE *out) {
+    BITMAP *bmp = create_bitmap_ex(8, CEEGEE_SCR_W, CEEGEE_SCR_H);
+    DATAFILE *data;
+    int req = req_id();
+    long glyphs = strlen(BENCH_TEXT) * (long)BENCH_TEXT_REPS;
+    long ms_textout, ms_glyphs;
+    clock_t start;
+    int a, y;
+
+    dep_require(RES_ID_FLIM, req);
+    dep_require_obj(FLIM_WHITE, req);
+    dep_require_obj(FLIM_GRAY, req);
+    data = dep_data_ref(RES_ID_FLIM);
+    if (!bmp || !FLIM_GLYPHS || !dep_ready_obj(FLIM_WHITE) ||
+        !dep_ready_obj(FLIM_GRAY)) {
+        fprintf(out, "\nText: can't load FLIM\n");
+        if (bmp) {
+            destroy_bitmap(bmp);
+        }
+        bench_text_forget(req);
+        return;
+    }
+    clear_bitmap(bmp);
+
+    start = clock();
+    for (a = 0; a < BENCH_TEXT_REPS; ++a) {
+        y = a % (CEEGEE_SCR_H - FLIM_GLYPHS->h);
+        textout_ex(bmp, data[FLIM_WHITE].dat, BENCH_TEXT, 0, y, 254, -1);
+        textout_ex(bmp, data[FLIM_GRAY].dat, BENCH_TEXT, 0, y, 253, -1);
+    }
+    ms_textout = bench_ms(start);
+
+    start = clock();
+    for (a = 0; a < BENCH_TEXT_REPS; ++a) {
+        y = a % (CEEGEE_SCR_H - FLIM_GLYPHS->h);
+        draw_glyphs(bmp, FLIM_GLYPHS, BENCH_TEXT, 0, y, 254, 253);
+    }
+    ms_glyphs = bench_ms(start);
+
+    fprintf(out, "\nText (%ld glyphs):\n\n", glyphs);
+    fprintf(out, "method                     ms   glyphs/s\n");
+    fprintf(
+        out, "textout_ex (2 layers) %7ld %10ld\n",
+        ms_textout, bench_rate(glyphs, ms_textout)
+    );
+    fprintf(
+        out, "draw_glyphs           %7ld %10ld\n",
+        ms_glyphs, bench_rate(glyphs, ms_glyphs)
+    );
+
+    destroy_bitmap(bmp);
+    bench_text_forget(req);
+}
+
+/**
+ * Spawns a pool full of entities and updates them for a number of frames.
+ * Every frame, some entities are removed and new ones are spawned in their
+ * place, to exercise the free list. Throughput is given in entity updates
+ * per second.
+ */
+void bench_entities(FILE *out) {
+    ENT_POOL *pool = ent_pool_create(BENCH_ENT_COUNT);
+    long updates = (long)BENCH_ENT_COUNT * BENCH_ENT_FRAMES;
+    long ms_spawn, ms_update;
+    clock_t start;
+    int a, b;
+
+    if (!pool) {
+        fprintf(out, "\nEntities: can't create pool\n");
+        return;
+    }
+
+    start = clock();
+    for (a = 0; a < BENCH_ENT_COUNT; ++a) {
+        ent_spawn(
+            pool,
+            itofix(a % CEEGEE_SCR_W),
+            itofix(a % CEEGEE_SCR_H),
+            itofix((a % 7) - 3) / 4,
+            itofix((a % 5) - 2) / 4,
+            NULL,
+            ENT_ENEMY
+        );
+    }
+    ms_spawn = bench_ms(start);
+
+    start = clock();
+    for (a = 0; a < BENCH_ENT_FRAMES; ++a) {
+        ent_update(pool);
+        for (b = 0; b < BENCH_ENT_CHURN; ++b) {
+            ent_kill_index(pool, (a * 31 + b * 17) % pool->count);
+            ent_spawn(pool, 0, 0, itofix(1), itofix(1), NULL, ENT_BULLET);
+        }
+    }
+    ms_update = bench_ms(start);
+
+    fprintf(
+        out, "\nEntities (%d, %d frames, %d replaced per frame):\n\n",
+        BENCH_ENT_COUNT, BENCH_ENT_FRAMES, BENCH_ENT_CHURN
+    );
+    fprintf(out, "step                       ms   entities/s\n");
+    fprintf(
+        out, "spawn                 %7ld %12ld\n",
+        ms_spawn, bench_rate(BENCH_ENT_COUNT, ms_spawn)
+    );
+    fprintf(
+        out, "update                %7ld %12ld\n",
+        ms_update, bench_rate(updates, ms_update)
+    );
+
+    ent_pool_destroy(pool);
+}
+
+/**
+ * Returns the number of overlapping pairs of entities found by comparing
+ * every entity to every other one. This is what the grid replaces.
+ */
+static long bench_all_pairs(ENT_POOL *pool, int size) {
+    long n = 0;
+    int a, b;
+
+    for (a = 0; a < pool->count; ++a) {
+        for (b = a + 1; b < pool->count; ++b) {
+            if (ABS(fixtoi(pool->x[a]) - fixtoi(pool->x[b])) < size &&
+                ABS(fixtoi(pool->y[a]) - fixtoi(pool->y[b])) < size) {
+                n += 1;
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * Moves a number of round objects around the playfield, and finds all
+ * pairs of overlapping objects every frame with the collision grid.
+ * The pairs are then checked with the objects' collision masks, which
+ * rules out pairs where only the corners overlap. For comparison, the pairs
+ * are also found once by checking every pair of bounding boxes.
+ */
+void bench_grid(FILE *out) {
+    ENT_POOL *pool = ent_pool_create(BENCH_GRID_COUNT);
+    COL_GRID *grid = pool ? grid_create(pool) : NULL;
+    GRID_PAIR *pairs = malloc(BENCH_GRID_PAIRS * sizeof(GRID_PAIR));
+    BITMAP *bmp = create_bitmap_ex(8, BENCH_GRID_SIZE, BENCH_GRID_SIZE);
+    RLE_SPRITE *spr = NULL;
+    SPR_FRAME *frame = NULL;
+    long ms_grid, ms_naive, found = 0, hits = 0, naive;
+    int r = (BENCH_GRID_SIZE - 1) / 2;
+    clock_t start;
+    int a, b, n;
+
+    if (bmp) {
+        clear_to_color(bmp, bitmap_mask_color(bmp));
+        circlefill(bmp, r, r, r, 1);
+        spr = get_rle_sprite(bmp);
+        frame = spr ? frame_create(spr) : NULL;
+    }
+    if (!pool || !grid || !pairs || !frame) {
+        fprintf(out, "\nCollision: can't allocate objects\n");
+    }
+    else {
+        for (a = 0; a < BENCH_GRID_COUNT; ++a) {
+            ent_spawn(
+                pool,
+                itofix((a * 37) % CEEGEE_SCR_W),
+                itofix((a * 53) % CEEGEE_SCR_H),
+                itofix((a % 3) - 1),
+                itofix((a % 5) - 2) / 2,
+                frame,
+                ENT_ENEMY
+            );
+        }
+
+        start = clock();
+        for (a = 0; a < BENCH_GRID_FRAMES; ++a) {
+            ent_update(pool);
+            grid_build(grid, ENT_ENEMY);
+            n = grid_pairs(grid, ENT_ENEMY, pairs, BENCH_GRID_PAIRS);
+            for (b = 0; b < n; ++b) {
+                hits += ent_collide(pool, pairs[b].a, pairs[b].b);
+            }
+            found += n;
+        }
+        ms_grid = bench_ms(start);
+
+        start = clock();
+        naive = bench_all_pairs(pool, BENCH_GRID_SIZE);
+        ms_naive = bench_ms(start);
+
+        fprintf(
+            out, "\nCollision (%d objects of %dx%d):\n\n",
+            BENCH_GRID_COUNT, BENCH_GRID_SIZE, BENCH_GRID_SIZE
+        );
+        fprintf(
+            out, "%-24s %8s %13s %13s\n",
+            "method", "ms/frame", "pairs/frame", "hits/frame"
+        );
+        fprintf(
+            out, "grid + masks (%d frames) %8ld %13ld %13ld\n",
+            BENCH_GRID_FRAMES, ms_grid / BENCH_GRID_FRAMES,
+            found / BENCH_GRID_FRAMES, hits / BENCH_GRID_FRAMES
+        );
+        fprintf(
+            out, "%-24s %8ld %13ld\n", "all pairs (1 frame)", ms_naive, naive
+        );
+    }
+
+    grid_destroy(grid);
+    ent_pool_destroy(pool);
+    frame_destroy(frame);
+    if (spr) {
+        destroy_rle_sprite(spr);
+    }
+    if (bmp) {
+        destroy_bitmap(bmp);
+    }
+    free(pairs);
+}
+
+/**
+ * Fills a particle system. The particles are spread over the screen and
+ * live long enough to last the whole benchmark; they may leave the screen,
+ * but aren't removed, so every frame has the same number of particles.
+ */
+static void bench_part_fill(PART_SYSTEM *sys) {
+    int a;
+
+    part_set_bounds(
+        sys, -CEEGEE_SCR_W, -CEEGEE_SCR_H, CEEGEE_SCR_W * 2, CEEGEE_SCR_H * 2
+    );
+    for (a = 0; a < sys->capacity; ++a) {
+        part_emit(
+            sys,
+            itofix((a * 37) % CEEGEE_SCR_W),
+            itofix((a * 53) % CEEGEE_SCR_H),
+            itofix((a % 5) - 2) / 4,
+            itofix((a % 3) - 1) / 4,
+            PART_LIFE_MAX
+        );
+    }
+}
+
+/**
+ * Updates a full particle system for a number of frames, and then draws
+ * it into an 8-bit memory bitmap for the same number of frames. Both 1x1
+ * and 2x2 particles are measured. The target is to update and draw 4096
+ * particles within 3 ms.
+ */
+void bench_particles(FILE *out) {
+    BITMAP *bmp = create_bitmap_ex(8, CEEGEE_SCR_W, CEEGEE_SCR_H);
+    PART_SYSTEM *sys;
+    long ms_update, ms_draw;
+    clock_t start;
+    int a, size;
+
+    if (!bmp) {
+        fprintf(out, "\nParticles: can't allocate bitmap\n");
+        return;
+    }
+    clear_bitmap(bmp);
+
+    fprintf(
+        out, "\nParticles (%d, %d frames):\n\n",
+        BENCH_PART_COUNT, BENCH_PART_FRAMES
+    );
+    fprintf(out, "size     update ms/frame   draw ms/frame\n");
+    for (size = 1; size <= 2; ++size) {
+        sys = part_create(BENCH_PART_COUNT, size);
+        if (!sys) {
+            continue;
+        }
+        part_set_ramp(sys, 0, 8, 32);
+        bench_part_fill(sys);
+
+        start = clock();
+        for (a = 0; a < BENCH_PART_FRAMES; ++a) {
+            part_update(sys);
+        }
+        ms_update = bench_ms(start);
+
+        start = clock();
+        for (a = 0; a < BENCH_PART_FRAMES; ++a) {
+            part_draw(sys, bmp);
+        }
+        ms_draw = bench_ms(start);
+
+        fprintf(
+            out, "%dx%d  %18.2f %15.2f\n", size, size,
+            (double)ms_update / BENCH_PART_FRAMES,
+            (double)ms_draw / BENCH_PART_FRAMES
+        );
+        part_destroy(sys);
+    }
+    destroy_bitmap(bmp);
+}
+
+/**
+ * Compares the two ways the flying handler can get its particles onto the
+ * screen: drawing them onto the screen itself, and drawing them into an
+ * 8-bit back buffer that's then blitted to the screen once per frame,
+ * which is what the game does. The blit is counted in every frame, even
+ * though the game does it once for everything it draws, not just for
+ * the particles. This sets the graphics mode for the duration.
+ */
+void bench_part_screen(FILE *out) {
+    BITMAP *bmp = create_bitmap_ex(8, CEEGEE_SCR_W, CEEGEE_SCR_H);
+    PART_SYSTEM *sys;
+    long ms_screen, ms_buffer;
+    clock_t start;
+    int a, size;
+
+    if (!bmp || screen_gfx_mode() != 0) {
+        fprintf(out, "\nParticles on screen: can't set graphics mode\n");
+        if (bmp) {
+            destroy_bitmap(bmp);
+        }
+        return;
+    }
+    clear_bitmap(bmp);
+
+    fprintf(
+        out, "\nParticles on screen (%d, %d frames):\n\n",
+        BENCH_PART_COUNT, BENCH_PART_FRAMES
+    );
+    fprintf(out, "size     screen ms/frame   buffer+blit ms/frame\n");
+    for (size = 1; size <= 2; ++size) {
+        sys = part_create(BENCH_PART_COUNT, size);
+        if (!sys) {
+            continue;
+        }
+        part_set_ramp(sys, 0, 8, 32);
+        bench_part_fill(sys);
+
+        start = clock();
+        for (a = 0; a < BENCH_PART_FRAMES; ++a) {
+            part_draw(sys, screen);
+        }
+        ms_screen = bench_ms(start);
+
+        start = clock();
+        for (a = 0; a < BENCH_PART_FRAMES; ++a) {
+            part_draw(sys, bmp);
+            blit(bmp, screen, 0, 0, 0, 0, bmp->w, bmp->h);
+        }
+        ms_buffer = bench_ms(start);
+
+        fprintf(
+            out, "%dx%d  %18.2f %22.2f\n", size, size,
+            (double)ms_screen / BENCH_PART_FRAMES,
+            (double)ms_buffer / BENCH_PART_FRAMES
+        );
+        part_destroy(sys);
+    }
+    screen_text_mode();
+    destroy_bitmap(bmp);
+}
+
+/**
+ * Draws a sprite at many angles and scales, first by rotating it every time
+ * and then by picking variants from a cache. The time taken to fill the
+ * cache, and the memory it takes, are measured as well.
+ */
+void bench_variants(FILE *out) {
+    BITMAP *bmp = create_bitmap_ex(8, CEEGEE_SCR_W, CEEGEE_SCR_H);
+    BITMAP *spr_bmp = create_bitmap_ex(8, BENCH_VAR_SIZE, BENCH_VAR_SIZE);
+    RLE_SPRITE *spr = NULL;
+    SPR_VARIANTS *v = NULL;
+    long ms_make = 0, ms_rotate, ms_cache;
+    int r = BENCH_VAR_SIZE / 2;
+    fixed angle, scale;
+    clock_t start;
+    int a;
+
+    if (spr_bmp) {
+        clear_to_color(spr_bmp, bitmap_mask_color(spr_bmp));
+        circlefill(spr_bmp, r, r, r - 1, 1);
+        rectfill(spr_bmp, r - 2, 0, r + 1, r, 2);
+        spr = get_rle_sprite(spr_bmp);
+    }
+    if (spr) {
+        start = clock();
+        v = variants_create(
+            spr, BENCH_VAR_ANGLES, BENCH_VAR_SCALES, itofix(1) / 2,
+            itofix(2), BENCH_VAR_BUDGET, false
+        );
+        ms_make = bench_ms(start);
+    }
+    if (!bmp || !v) {
+        fprintf(out, "\nRotation: can't allocate objects\n");
+    }
+    else {
+        clear_bitmap(bmp);
+        start = clock();
+        for (a = 0; a < BENCH_VAR_DRAWS; ++a) {
+            angle = itofix(a * 7);
+            scale = itofix(1) / 2 + (itofix(3) / 2) * (a % 16) / 15;
+            rotate_scaled_sprite(
+                bmp, spr_bmp, (a * 37) % CEEGEE_SCR_W,
+                (a * 53) % CEEGEE_SCR_H, angle, scale
+            );
+        }
+        ms_rotate = bench_ms(start);
+
+        start = clock();
+        batch_begin(bmp);
+        for (a = 0; a < BENCH_VAR_DRAWS; ++a) {
+            angle = itofix(a * 7);
+            scale = itofix(1) / 2 + (itofix(3) / 2) * (a % 16) / 15;
+            variants_draw(
+                v, (a * 37) % CEEGEE_SCR_W, (a * 53) % CEEGEE_SCR_H,
+                angle, scale, LAYER_ENEMIES
+            );
+            // The batch can only hold so many sprites per frame.
+            if ((a + 1) % BATCH_MAX == 0) {
+                batch_end();
+                batch_begin(bmp);
+            }
+        }
+        batch_end();
+        ms_cache = bench_ms(start);
+
+        fprintf(
+            out, "\nRotation (%dx%d sprite, %d draws):\n\n",
+            BENCH_VAR_SIZE, BENCH_VAR_SIZE, BENCH_VAR_DRAWS
+        );
+        fprintf(
+            out, "variants: %d of %d, %ld bytes, made in %ld ms\n",
+            v->count, BENCH_VAR_ANGLES * BENCH_VAR_SCALES, v->used, ms_make
+        );
+        fprintf(out, "%-24s %8s\n", "method", "ms");
+        fprintf(out, "%-24s %8ld\n", "rotate_scaled_sprite()", ms_rotate);
+        fprintf(out, "%-24s %8ld\n", "variant cache", ms_cache);
+    }
+
+    variants_destroy(v);
+    if (spr) {
+        destroy_rle_sprite(spr);
+    }
+    if (spr_bmp) {
+        destroy_bitmap(spr_bmp);
+    }
+    if (bmp) {
+        destroy_bitmap(bmp);
+    }
+}
+
+/**
+ * Runs all benchmarks and writes the results to a file.
+ */
+void run_benchmarks(FILE *out) {
+    fprintf(out, "Benchmarks:\n\n");
+    bench_pack(out);
+    bench_text(out);
+    bench_entities(out);
+    bench_grid(out);
+    bench_particles(out);
+    bench_part_screen(out);
+    bench_variants(out);
+}
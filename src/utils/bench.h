@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <allegro.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifndef __CEEGEE_UTILS_BENCH__
+#define __CEEGEE_UTILS_BENCH__
+
+#include "src/game/entities/particles.h"
+#include "src/game/entities/pool.h"
+
+// Number of times each object is loaded by the pack benchmark.
+#define BENCH_PACK_REPS 20
+// Number of times the text benchmark draws its string.
+#define BENCH_TEXT_REPS 2000
+// Number of entities spawned by the entity benchmark, the number of
+// frames it updates them for, and how many are replaced every frame.
+#define BENCH_ENT_COUNT 10000
+#define BENCH_ENT_FRAMES 100
+#define BENCH_ENT_CHURN 500
+// Number of moving objects in the collision benchmark, their size,
+// and the number of frames the grid is rebuilt and queried for.
+#define BENCH_GRID_COUNT 5000
+#define BENCH_GRID_SIZE 8
+#define BENCH_GRID_FRAMES 50
+// Largest number of pairs the collision benchmark keeps per frame.
+#define BENCH_GRID_PAIRS 65536
+// Number of live particles in the particle benchmark, and the number
+// of frames they're updated and drawn for.
+#define BENCH_PART_COUNT 4096
+#define BENCH_PART_FRAMES 100
+// Size of the sprite in the rotation benchmark, the number of rotation
+// steps and scale levels it caches, the memory budget for them, and the
+// number of times the sprite is drawn.
+#define BENCH_VAR_SIZE 32
+#define BENCH_VAR_ANGLES 32
+#define BENCH_VAR_SCALES 4
+#define BENCH_VAR_BUDGET 262144L
+#define BENCH_VAR_DRAWS 2000
+
+static long bench_all_pairs(ENT_POOL *pool, int size);
+static long bench_ms(clock_t start);
+static void bench_part_fill(PART_SYSTEM *sys);
+static long bench_rate(long n, long ms);
+static void bench_text_forget(int req);
+void bench_entities(FILE *out);
+void bench_grid(FILE *out);
+void bench_pack(FILE *out);
+void bench_part_screen(FILE *out);
+void bench_particles(FILE *out);
+void bench_text(FILE *out);
+void bench_variants(FILE *out);
+void run_benchmarks(FILE *out);
+
+#endif
@@ -6,7 +6,6 @@
 #include "src/utils/counters.h"
 
 int counter_req_id = 0;
-int counter_res_id = 0;
 
 /**
  * Returns the next global ID for requesters.
@@ -14,10 +13,3 @@ int counter_res_id = 0;
 int req_id() {
     return counter_req_id++;
 }
-
-/**
- * Returns the next global ID for resources.
- */
-int res_id() {
-    return counter_res_id++;
-}
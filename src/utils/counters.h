@@ -7,6 +7,5 @@
 #define __CEEGEE_UTILS_COUNTERS__
 
 int req_id();
-int res_id();
 
 #endif
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <string.h>
+
+#include "src/utils/lz4.h"
+
+/**
+ * Decompresses a block in the LZ4 block format. This format is made of
+ * sequences, each consisting of a run of literal bytes followed by
+ * a match: a copy of earlier output. Unlike LZSS, there are no flag bits
+ * to test per byte, so literals and matches are copied whole.
+ *
+ * Returns the number of bytes written to dst, or -1 if the block
+ * is corrupt or doesn't fit in dst_len bytes.
+ */
+int lz4_decompress(
+    const unsigned char *src, int src_len, unsigned char *dst, int dst_len
+) {
+    const unsigned char *ip = src;
+    const unsigned char *iend = src + src_len;
+    unsigned char *op = dst;
+    unsigned char *oend = dst + dst_len;
+    unsigned char *match;
+    unsigned int token, len, offset, b;
+
+    while (ip < iend) {
+        token = *ip++;
+
+        // Copy the literals. A length of 15 is followed by more length bytes.
+        len = token >> 4;
+        if (len == 15) {
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        if (len > (unsigned int)(iend - ip) ||
+            len > (unsigned int)(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, len);
+        ip += len;
+        op += len;
+
+        // The last sequence only has literals.
+        if (ip >= iend) {
+            break;
+        }
+
+        // Copy the match.
+        if (iend - ip < 2) {
+            return -1;
+        }
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (unsigned int)(op - dst)) {
+            return -1;
+        }
+        len = token & 15;
+        if (len == 15) {
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        len += LZ4_MIN_MATCH;
+        if (len > (unsigned int)(oend - op)) {
+            return -1;
+        }
+
+        // Matches can overlap the output (e.g. a run of one color),
+        // so copy byte by byte unless they're far enough apart.
+        match = op - offset;
+        if (offset >= len) {
+            memcpy(op, match, len);
+            op += len;
+        }
+        else {
+            while (len--) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return op - dst;
+}
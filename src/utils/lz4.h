@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#ifndef __CEEGEE_UTILS_LZ4__
+#define __CEEGEE_UTILS_LZ4__
+
+// Smallest match the format can encode.
+#define LZ4_MIN_MATCH 4
+// The last match must start at least this many bytes before the end,
+// and the last literals must be at least this many bytes long.
+#define LZ4_MF_LIMIT 12
+#define LZ4_LAST_LITERALS 5
+// Largest distance between a match and the data it copies.
+#define LZ4_MAX_OFFSET 65535
+
+int lz4_decompress(
+    const unsigned char *src, int src_len, unsigned char *dst, int dst_len
+);
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+/*
+ * atlasbake: packs a number of 8-bit PCX images into an ATL object
+ * for the pack, e.g. all animation frames of a sprite.
+ *
+ * Usage: atlasbake <output.atl> <frame.pcx> [<frame.pcx> ...]
+ *
+ * This runs on the host when the pack is built, not in the game.
+ * Every frame is converted to Allegro's 8-bit RLE sprite format, with
+ * color 0 being transparent, so the game can use the frames as soon as
+ * they're read. See src/gfx/deps/atlas.c for the format.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tools/pcx.h"
+
+// Maximum number of frames in an atlas.
+#define ATL_FRAMES_MAX 256
+// Longest runs of solid and transparent pixels in one RLE count.
+#define RLE_SOLID_MAX 127
+#define RLE_SKIP_MAX 128
+
+/**
+ * Converts an image to an 8-bit RLE sprite, the same way Allegro's
+ * get_rle_sprite() does. Every row is a list of runs, each starting with
+ * a signed count: a positive count is followed by that many pixels, and
+ * a negative count skips that many transparent pixels. A count of zero
+ * ends the row. dst must be able to hold w * h * 2 + h bytes.
+ * Returns the size of the RLE data.
+ */
+static long encode_rle(unsigned char *pixels, int w, int h,
+    signed char *dst)
+{
+    signed char *count;
+    unsigned char c;
+    long op = 0;
+    int x, y;
+
+    for (y = 0; y < h; ++y) {
+        count = NULL;
+        for (x = 0; x < w; ++x) {
+            c = pixels[(long)y * w + x];
+            if (c != 0) {
+                if (!count || *count <= 0 || *count == RLE_SOLID_MAX) {
+                    count = &dst[op++];
+                    *count = 0;
+                }
+                *count += 1;
+                dst[op++] = c;
+            }
+            else {
+                if (!count || *count >= 0 || *count == -RLE_SKIP_MAX) {
+                    count = &dst[op++];
+                    *count = 0;
+                }
+                *count -= 1;
+            }
+        }
+        dst[op++] = 0;
+    }
+    return op;
+}
+
+/**
+ * Writes a 16 or 32-bit little endian value.
+ */
+static void write_le(FILE *f, unsigned long value, int bytes) {
+    while (bytes--) {
+        fputc(value & 0xFF, f);
+        value >>= 8;
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned char *pixels;
+    signed char *rle[ATL_FRAMES_MAX];
+    long size[ATL_FRAMES_MAX], total = 0;
+    int w[ATL_FRAMES_MAX], h[ATL_FRAMES_MAX];
+    int a, n = argc - 2;
+    FILE *f;
+
+    if (argc < 3 || n > ATL_FRAMES_MAX) {
+        fprintf(
+            stderr, "Usage: %s <output.atl> <frame.pcx> [<frame.pcx> ...]\n",
+            argv[0]
+        );
+        return 1;
+    }
+    for (a = 0; a < n; ++a) {
+        pixels = read_pcx(argv[a + 2], &w[a], &h[a]);
+        if (!pixels) {
+            fprintf(stderr, "%s: can't read %s\n", argv[0], argv[a + 2]);
+            return 1;
+        }
+        rle[a] = malloc((long)w[a] * h[a] * 2 + h[a]);
+        size[a] = encode_rle(pixels, w[a], h[a], rle[a]);
+        total += size[a];
+        free(pixels);
+    }
+
+    f = fopen(argv[1], "wb");
+    if (!f) {
+        fprintf(stderr, "%s: can't write %s\n", argv[0], argv[1]);
+        return 1;
+    }
+    write_le(f, n, 2);
+    for (a = 0; a < n; ++a) {
+        write_le(f, w[a], 2);
+        write_le(f, h[a], 2);
+        write_le(f, size[a], 4);
+    }
+    for (a = 0; a < n; ++a) {
+        fwrite(rle[a], 1, size[a], f);
+        free(rle[a]);
+    }
+    fclose(f);
+
+    printf("%s: %d frames, %ld bytes of RLE data\n", argv[1], n, total);
+    return 0;
+}
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+/*
+ * glyphbake: merges the two layers of a font into a GLY object for the pack.
+ *
+ * Usage: glyphbake <output.gly> <layer_a.pcx> <layer_b.pcx>
+ *
+ * This runs on the host when the pack is built, not in the game.
+ * Both layers are font images in the format Allegro's grabber uses: every
+ * character is a box bordered by color 255, from left to right and top to
+ * bottom, starting at the space. Any other nonzero pixel is part of the
+ * character. Layer b is drawn on top of layer a, and the result is stored
+ * as horizontal spans of one layer or the other, which the game draws as
+ * they are. See src/gfx/glyphs.c for the format.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tools/pcx.h"
+
+// Range of characters in a glyph set; these must match src/gfx/glyphs.h.
+#define GLYPH_FIRST 32
+#define GLYPH_LAST 126
+#define GLYPH_COUNT (GLYPH_LAST - GLYPH_FIRST + 1)
+#define GLYPH_CLEAR 0
+#define GLYPH_COLOR_A 1
+#define GLYPH_COLOR_B 2
+
+// Color of the borders around the characters.
+#define FONT_BORDER 255
+// Character that's drawn in place of ones that aren't in the font,
+// like Allegro does.
+#define FONT_MISSING '^'
+
+// A character's box in a font image.
+typedef struct GLYPH_BOX {
+    int x, y, w, h;
+} GLYPH_BOX;
+
+// Font image and the boxes of the characters in it.
+typedef struct FONT_IMAGE {
+    unsigned char *pixels;
+    int w, h;
+    int n;
+    GLYPH_BOX boxes[GLYPH_COUNT];
+} FONT_IMAGE;
+
+/**
+ * Returns a pixel of a font image, or 0 if it's outside of it.
+ */
+static int font_pixel(FONT_IMAGE *img, int x, int y) {
+    if (x < 0 || y < 0 || x >= img->w || y >= img->h) {
+        return 0;
+    }
+    return img->pixels[(long)y * img->w + x];
+}
+
+/**
+ * Finds the next character's box from x, y onward, the same way Allegro
+ * does: its top left corner is a border pixel with border pixels to its
+ * right and below it, but not diagonally. Returns 0 if there are no more.
+ */
+static int find_box(FONT_IMAGE *img, int *x, int *y, GLYPH_BOX *box) {
+    while (font_pixel(img, *x, *y) != FONT_BORDER ||
+        font_pixel(img, *x + 1, *y) != FONT_BORDER ||
+        font_pixel(img, *x, *y + 1) != FONT_BORDER ||
+        font_pixel(img, *x + 1, *y + 1) == FONT_BORDER) {
+        if (++*x >= img->w) {
+            *x = 0;
+            if (++*y >= img->h) {
+                return 0;
+            }
+        }
+    }
+    box->x = *x + 1;
+    box->y = *y + 1;
+    box->w = 0;
+    while (font_pixel(img, *x + box->w + 1, *y) == FONT_BORDER &&
+        font_pixel(img, *x + box->w + 1, *y + 1) != FONT_BORDER) {
+        box->w += 1;
+    }
+    box->h = 0;
+    while (font_pixel(img, *x, *y + box->h + 1) == FONT_BORDER &&
+        font_pixel(img, *x + 1, *y + box->h + 1) != FONT_BORDER) {
+        box->h += 1;
+    }
+    *x += box->w;
+    return box->w > 0 && box->h > 0;
+}
+
+/**
+ * Reads a font image and finds its characters.
+ * Returns 0 if it can't be read or has no characters.
+ */
+static int read_font(char *fn, FONT_IMAGE *img) {
+    int x = 0, y = 0;
+
+    img->pixels = read_pcx(fn, &img->w, &img->h);
+    if (!img->pixels) {
+        return 0;
+    }
+    img->n = 0;
+    while (img->n < GLYPH_COUNT && find_box(img, &x, &y, &img->boxes[img->n])) {
+        img->n += 1;
+    }
+    return img->n > 0;
+}
+
+/**
+ * Returns the box of a character, or NULL if the font doesn't have it
+ * nor the character used in place of missing ones.
+ */
+static GLYPH_BOX *font_box(FONT_IMAGE *img, int c) {
+    if (c - GLYPH_FIRST < img->n) {
+        return &img->boxes[c - GLYPH_FIRST];
+    }
+    if (FONT_MISSING - GLYPH_FIRST < img->n) {
+        return &img->boxes[FONT_MISSING - GLYPH_FIRST];
+    }
+    return NULL;
+}
+
+/**
+ * Draws a character of one layer into a glyph buffer of w by h pixels.
+ */
+static void draw_layer(FONT_IMAGE *img, int c, unsigned char *buf, int w,
+    int h, int color)
+{
+    GLYPH_BOX *box = font_box(img, c);
+    int x, y;
+
+    if (!box) {
+        return;
+    }
+    for (y = 0; y < box->h && y < h; ++y) {
+        for (x = 0; x < box->w && x < w; ++x) {
+            if (font_pixel(img, box->x + x, box->y + y) != 0) {
+                buf[y * w + x] = color;
+            }
+        }
+    }
+}
+
+/**
+ * Appends the spans of the first w columns of a glyph buffer to a span
+ * list, four bytes each: x, y, length and layer. The buffer's rows are
+ * stride bytes apart. Transparent pixels are skipped.
+ * Returns the number of spans.
+ */
+static int glyph_spans(unsigned char *buf, int stride, int w, int h,
+    unsigned char *dst)
+{
+    int x, y, start, c, n = 0;
+
+    for (y = 0; y < h; ++y) {
+        for (x = 0; x < w; ) {
+            c = buf[y * stride + x];
+            start = x;
+            while (x < w && buf[y * stride + x] == c) {
+                x += 1;
+            }
+            if (c == GLYPH_CLEAR) {
+                continue;
+            }
+            dst[n * 4] = start;
+            dst[n * 4 + 1] = y;
+            dst[n * 4 + 2] = x - start;
+            dst[n * 4 + 3] = c;
+            n += 1;
+        }
+    }
+    return n;
+}
+
+/**
+ * Draws n spans back into a glyph buffer the way the game does, and checks
+ * that the result matches the first w columns of the buffer they were made
+ * from. Both buffers' rows are stride bytes apart.
+ * Returns 0 if they don't match.
+ */
+static int check_spans(unsigned char *spans, int n, unsigned char *buf,
+    unsigned char *check, int stride, int w, int h)
+{
+    int a, x, y;
+
+    memset(check, GLYPH_CLEAR, stride * h);
+    for (a = 0; a < n; ++a, spans += 4) {
+        if (spans[0] + spans[2] > w || spans[1] >= h) {
+            return 0;
+        }
+        memset(check + spans[1] * stride + spans[0], spans[3], spans[2]);
+    }
+    for (y = 0; y < h; ++y) {
+        for (x = 0; x < w; ++x) {
+            if (check[y * stride + x] != buf[y * stride + x]) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * Writes a 16 or 32-bit little endian value.
+ */
+static void write_le(FILE *f, unsigned long value, int bytes) {
+    while (bytes--) {
+        fputc(value & 0xFF, f);
+        value >>= 8;
+    }
+}
+
+int main(int argc, char **argv) {
+    FONT_IMAGE layer_a, layer_b;
+    GLYPH_BOX *box;
+    unsigned char *buf, *check, *spans;
+    int widths[GLYPH_COUNT], counts[GLYPH_COUNT];
+    int a, w = 1, h, n = 0;
+    FILE *f;
+
+    if (argc != 4) {
+        fprintf(
+            stderr, "Usage: %s <output.gly> <layer_a.pcx> <layer_b.pcx>\n",
+            argv[0]
+        );
+        return 1;
+    }
+    for (a = 0; a < 2; ++a) {
+        if (!read_font(argv[a + 2], a == 0 ? &layer_a : &layer_b)) {
+            fprintf(stderr, "%s: can't read %s\n", argv[0], argv[a + 2]);
+            return 1;
+        }
+    }
+
+    // Allegro takes a font's height from its first character. Widths come
+    // from layer a; layer b is cut off at the same width.
+    h = layer_a.boxes[0].h;
+    if (layer_b.boxes[0].h > h) {
+        h = layer_b.boxes[0].h;
+    }
+    for (a = 0; a < GLYPH_COUNT; ++a) {
+        box = font_box(&layer_a, GLYPH_FIRST + a);
+        widths[a] = box ? box->w : 0;
+        if (widths[a] > w) {
+            w = widths[a];
+        }
+    }
+    if (w > 255 || h > 255) {
+        fprintf(stderr, "%s: characters are too large\n", argv[0]);
+        return 1;
+    }
+
+    // A glyph has at most one span per pixel. Every glyph is drawn into
+    // a buffer as wide as the widest one, and its spans are then checked
+    // by drawing them back, so that a broken set is never written.
+    buf = malloc(w * h);
+    check = malloc(w * h);
+    spans = malloc((long)GLYPH_COUNT * w * h * 4);
+    if (!buf || !check || !spans) {
+        fprintf(stderr, "%s: out of memory\n", argv[0]);
+        return 1;
+    }
+    for (a = 0; a < GLYPH_COUNT; ++a) {
+        memset(buf, GLYPH_CLEAR, w * h);
+        draw_layer(&layer_a, GLYPH_FIRST + a, buf, w, h, GLYPH_COLOR_A);
+        draw_layer(&layer_b, GLYPH_FIRST + a, buf, w, h, GLYPH_COLOR_B);
+        counts[a] = glyph_spans(buf, w, widths[a], h, spans + n * 4);
+        if (!check_spans(spans + n * 4, counts[a], buf, check, w, widths[a],
+            h)) {
+            fprintf(
+                stderr, "%s: glyph '%c' doesn't match its spans\n", argv[0],
+                GLYPH_FIRST + a
+            );
+            return 1;
+        }
+        n += counts[a];
+    }
+
+    f = fopen(argv[1], "wb");
+    if (!f) {
+        fprintf(stderr, "%s: can't write %s\n", argv[0], argv[1]);
+        return 1;
+    }
+    write_le(f, h, 2);
+    write_le(f, GLYPH_COUNT, 2);
+    write_le(f, n, 4);
+    for (a = 0; a < GLYPH_COUNT; ++a) {
+        write_le(f, widths[a], 2);
+        write_le(f, counts[a], 2);
+    }
+    fwrite(spans, 4, n, f);
+    fclose(f);
+
+    printf("%s: %d glyphs, %d spans\n", argv[1], GLYPH_COUNT, n);
+    free(buf);
+    free(check);
+    free(spans);
+    free(layer_a.pixels);
+    free(layer_b.pixels);
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+/*
+ * lzbake: converts an 8-bit PCX image into an LZB object for the pack.
+ *
+ * Usage: lzbake <input.pcx> <output.lzb>
+ *
+ * This runs on the host when the pack is built, not in the game.
+ * The image is compressed as an LZ4 block, unless that doesn't save enough
+ * space to be worth it, in which case the pixels are stored as-is.
+ * See src/gfx/deps/lzbmp.c for the format.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/utils/lz4.h"
+#include "tools/pcx.h"
+
+// Storage methods; these must match src/gfx/deps/lzbmp.h.
+#define LZBMP_STORED 0
+#define LZBMP_LZ4 1
+
+// LZ4 is only used if it makes the image at least this much smaller
+// (in eighths). Below that, the time spent decoding isn't won back
+// by reading fewer bytes, and stored pixels are copied straight in.
+#define LZB_MIN_SAVING 1
+
+// Number of bits in the match finder's hash.
+#define HASH_BITS 12
+#define HASH_SIZE (1 << HASH_BITS)
+
+/**
+ * Writes an LZ4 length that doesn't fit in a token.
+ */
+static int write_length(unsigned char *dst, int op, int len) {
+    while (len >= 255) {
+        dst[op++] = 255;
+        len -= 255;
+    }
+    dst[op++] = len;
+    return op;
+}
+
+/**
+ * Writes one sequence: literals, followed by a match if mlen is nonzero.
+ */
+static int write_sequence(
+    unsigned char *dst, int op, const unsigned char *lit, int llen,
+    int offset, int mlen
+) {
+    int tl = llen < 15 ? llen : 15;
+    int tm = mlen - LZ4_MIN_MATCH < 15 ? mlen - LZ4_MIN_MATCH : 15;
+
+    if (mlen == 0) {
+        tm = 0;
+    }
+    dst[op++] = (tl << 4) | tm;
+    if (tl == 15) {
+        op = write_length(dst, op, llen - 15);
+    }
+    memcpy(dst + op, lit, llen);
+    op += llen;
+    if (mlen == 0) {
+        return op;
+    }
+    dst[op++] = offset & 0xFF;
+    dst[op++] = offset >> 8;
+    if (tm == 15) {
+        op = write_length(dst, op, mlen - LZ4_MIN_MATCH - 15);
+    }
+    return op;
+}
+
+/**
+ * Compresses data into an LZ4 block using a greedy match finder.
+ * dst must be able to hold len + (len / 255) + 16 bytes.
+ * Returns the compressed size.
+ */
+static int lz4_compress(const unsigned char *src, int len, unsigned char *dst) {
+    int hash[HASH_SIZE];
+    int ip = 0, anchor = 0, op = 0;
+    int limit = len - LZ4_MF_LIMIT;
+    int h, ref, mlen;
+    unsigned long seq;
+
+    for (h = 0; h < HASH_SIZE; ++h) {
+        hash[h] = -1;
+    }
+    while (ip < limit) {
+        seq = src[ip] | (src[ip + 1] << 8) | (src[ip + 2] << 16) |
+            ((unsigned long)src[ip + 3] << 24);
+        h = ((seq * 2654435761UL) & 0xFFFFFFFFUL) >> (32 - HASH_BITS);
+        ref = hash[h];
+        hash[h] = ip;
+        if (ref < 0 || ip - ref > LZ4_MAX_OFFSET ||
+            memcmp(src + ref, src + ip, LZ4_MIN_MATCH) != 0) {
+            ip += 1;
+            continue;
+        }
+        mlen = LZ4_MIN_MATCH;
+        while (ip + mlen < len - LZ4_LAST_LITERALS &&
+            src[ref + mlen] == src[ip + mlen]) {
+            mlen += 1;
+        }
+        op = write_sequence(
+            dst, op, src + anchor, ip - anchor, ip - ref, mlen
+        );
+        ip += mlen;
+        anchor = ip;
+    }
+    return write_sequence(dst, op, src + anchor, len - anchor, 0, 0);
+}
+
+/**
+ * Writes a 16 or 32-bit little endian value.
+ */
+static void write_le(FILE *f, unsigned long value, int bytes) {
+    while (bytes--) {
+        fputc(value & 0xFF, f);
+        value >>= 8;
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned char *pixels, *packed, *check;
+    int w, h, size, packed_size, method;
+    FILE *f;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <input.pcx> <output.lzb>\n", argv[0]);
+        return 1;
+    }
+    pixels = read_pcx(argv[1], &w, &h);
+    if (!pixels) {
+        fprintf(stderr, "%s: can't read %s\n", argv[0], argv[1]);
+        return 1;
+    }
+    size = w * h;
+    packed = malloc(size + (size / 255) + 16);
+    packed_size = lz4_compress(pixels, size, packed);
+
+    // Make sure the game will be able to decompress this.
+    check = malloc(size);
+    if (lz4_decompress(packed, packed_size, check, size) != size ||
+        memcmp(check, pixels, size) != 0) {
+        fprintf(stderr, "%s: %s doesn't decompress correctly\n", argv[0],
+            argv[1]);
+        return 1;
+    }
+    free(check);
+
+    method = LZBMP_LZ4;
+    if (packed_size * 8 > size * (8 - LZB_MIN_SAVING)) {
+        method = LZBMP_STORED;
+        packed_size = size;
+        memcpy(packed, pixels, size);
+    }
+
+    f = fopen(argv[2], "wb");
+    if (!f) {
+        fprintf(stderr, "%s: can't write %s\n", argv[0], argv[2]);
+        return 1;
+    }
+    write_le(f, w, 2);
+    write_le(f, h, 2);
+    fputc(method, f);
+    write_le(f, packed_size, 4);
+    fwrite(packed, 1, packed_size, f);
+    fclose(f);
+
+    printf(
+        "%s: %dx%d, %d -> %d bytes (%s)\n", argv[2], w, h, size, packed_size,
+        method == LZBMP_LZ4 ? "lz4" : "stored"
+    );
+    free(packed);
+    free(pixels);
+    return 0;
+}
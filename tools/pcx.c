@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tools/pcx.h"
+
+/**
+ * Reads an 8-bit, single plane PCX file. Returns the pixels, or NULL
+ * if the file can't be read or is in an unsupported format.
+ */
+unsigned char *read_pcx(char *fn, int *w, int *h) {
+    FILE *f = fopen(fn, "rb");
+    unsigned char hdr[128];
+    unsigned char *pixels, *row;
+    int x, y, bpl, c, count;
+
+    if (!f) {
+        return NULL;
+    }
+    if (fread(hdr, 1, 128, f) != 128 || hdr[0] != 10 || hdr[3] != 8 ||
+        hdr[65] != 1) {
+        fclose(f);
+        return NULL;
+    }
+    *w = (hdr[8] | (hdr[9] << 8)) - (hdr[4] | (hdr[5] << 8)) + 1;
+    *h = (hdr[10] | (hdr[11] << 8)) - (hdr[6] | (hdr[7] << 8)) + 1;
+    bpl = hdr[66] | (hdr[67] << 8);
+    // Each decoded row is copied into the image, so it must be wide enough.
+    if (*w <= 0 || *h <= 0 || bpl < *w) {
+        fclose(f);
+        return NULL;
+    }
+
+    pixels = malloc((long)*w * *h);
+    row = malloc(bpl);
+    if (!pixels || !row) {
+        free(row);
+        free(pixels);
+        fclose(f);
+        return NULL;
+    }
+    for (y = 0; y < *h; ++y) {
+        // Every row is run-length encoded separately.
+        for (x = 0; x < bpl; ) {
+            c = fgetc(f);
+            count = 1;
+            if ((c & 0xC0) == 0xC0) {
+                count = c & 0x3F;
+                c = fgetc(f);
+            }
+            if (c == EOF) {
+                free(row);
+                free(pixels);
+                fclose(f);
+                return NULL;
+            }
+            while (count-- && x < bpl) {
+                row[x++] = c;
+            }
+        }
+        memcpy(pixels + (long)y * *w, row, *w);
+    }
+    free(row);
+    fclose(f);
+    return pixels;
+}
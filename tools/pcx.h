@@ -0,0 +1,11 @@
+/*
+ * Copyright (C) 2016, Michiel Sikma <michiel@sikma.org>
+ * MIT License
+ */
+
+#ifndef __CEEGEE_TOOLS_PCX__
+#define __CEEGEE_TOOLS_PCX__
+
+unsigned char *read_pcx(char *fn, int *w, int *h);
+
+#endif